@@ -0,0 +1,255 @@
+#ifndef ALLOC_STATS_H
+#define ALLOC_STATS_H
+
+// Allocation accounting.
+//
+// Build with -DALLOC_STATS and include this before anything else in
+// the translation unit. It routes the allocation macros of the rax
+// headers, plus malloc/calloc/realloc/free/strdup, through counting
+// wrappers. Every block carries a small header recording its size,
+// family and owner, so it can be freed by any of the wrappers.
+//
+// Allocations are charged to the stats block set with
+// alloc_stats_begin() on the current thread, or to alloc_stats_global.
+// Pool jobs run under the block that was current when they were
+// submitted, so solvers that fan out to worker threads are still
+// charged for them.
+//
+// Without -DALLOC_STATS nothing is overridden and the begin/end calls
+// compile to nothing.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum alloc_family {
+    ALLOC_DA,
+    ALLOC_HT,
+    ALLOC_HSET,
+    ALLOC_STRV,
+    ALLOC_LIBC, // Plain malloc & co in solver code
+    ALLOC_FAMILIES,
+};
+
+#ifdef ALLOC_STATS
+
+#include <stdatomic.h>
+
+static const char *alloc_family_names[ALLOC_FAMILIES] = {
+    [ALLOC_DA] = "da",
+    [ALLOC_HT] = "ht",
+    [ALLOC_HSET] = "hset",
+    [ALLOC_STRV] = "strv",
+    [ALLOC_LIBC] = "libc",
+};
+
+struct alloc_counters {
+    atomic_size_t allocs;   // malloc, calloc and realloc(NULL, ...)
+    atomic_size_t reallocs;
+    atomic_size_t frees;
+    atomic_size_t bytes;    // Total bytes requested, including reallocs
+    atomic_size_t live;
+    atomic_size_t peak;
+};
+
+struct alloc_stats {
+    struct alloc_counters family[ALLOC_FAMILIES];
+    struct alloc_counters total;
+};
+
+typedef union {
+    struct {
+        size_t size;
+        struct alloc_stats *owner;
+        int family;
+    } h;
+    max_align_t align;
+} alloc__header;
+
+static struct alloc_stats alloc_stats_global;
+static _Thread_local struct alloc_stats *alloc__current = NULL;
+
+// Charge allocations on this thread to stats until alloc_stats_end().
+// Returns the previous block, to pass to alloc_stats_end().
+static inline struct alloc_stats *alloc_stats_begin(struct alloc_stats *stats)
+{
+    struct alloc_stats *prev = alloc__current;
+    alloc__current = stats;
+    return prev;
+}
+
+static inline void alloc_stats_end(struct alloc_stats *prev)
+{
+    alloc__current = prev;
+}
+
+// The block allocations on this thread are charged to, NULL for global
+static inline struct alloc_stats *alloc_stats_current(void)
+{
+    return alloc__current;
+}
+
+static inline void alloc__raise_peak(struct alloc_counters *c, size_t live)
+{
+    size_t peak = atomic_load_explicit(&c->peak, memory_order_relaxed);
+    while (live > peak
+           && !atomic_compare_exchange_weak_explicit(&c->peak, &peak, live,
+                                                     memory_order_relaxed,
+                                                     memory_order_relaxed));
+}
+
+static inline void alloc__count_add(struct alloc_counters *c, size_t size, bool is_realloc)
+{
+    atomic_fetch_add_explicit(is_realloc ? &c->reallocs : &c->allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->bytes, size, memory_order_relaxed);
+    size_t live = atomic_fetch_add_explicit(&c->live, size, memory_order_relaxed) + size;
+    alloc__raise_peak(c, live);
+}
+
+static inline void alloc__count_remove(struct alloc_counters *c, size_t size, bool is_realloc)
+{
+    if (!is_realloc)
+        atomic_fetch_add_explicit(&c->frees, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&c->live, size, memory_order_relaxed);
+}
+
+static inline void *alloc__track(alloc__header *head, int family, size_t size, bool is_realloc)
+{
+    struct alloc_stats *owner = alloc__current ? alloc__current : &alloc_stats_global;
+    head->h.size = size;
+    head->h.owner = owner;
+    head->h.family = family;
+
+    alloc__count_add(&owner->family[family], size, is_realloc);
+    alloc__count_add(&owner->total, size, is_realloc);
+    return head + 1;
+}
+
+static inline void alloc__untrack(const alloc__header *head, bool is_realloc)
+{
+    struct alloc_stats *owner = head->h.owner;
+    alloc__count_remove(&owner->family[head->h.family], head->h.size, is_realloc);
+    alloc__count_remove(&owner->total, head->h.size, is_realloc);
+}
+
+static inline void *alloc_stats_malloc(int family, size_t size)
+{
+    if (size > SIZE_MAX - sizeof(alloc__header)) return NULL;
+
+    alloc__header *head = malloc(sizeof(*head) + size);
+    if (!head) return NULL;
+    return alloc__track(head, family, size, false);
+}
+
+static inline void *alloc_stats_calloc(int family, size_t n, size_t size)
+{
+    if (size != 0 && n > (SIZE_MAX - sizeof(alloc__header)) / size) return NULL;
+
+    alloc__header *head = calloc(1, sizeof(*head) + n * size);
+    if (!head) return NULL;
+    return alloc__track(head, family, n * size, false);
+}
+
+static inline void *alloc_stats_realloc(int family, void *ptr, size_t size)
+{
+    if (!ptr) return alloc_stats_malloc(family, size);
+    if (size > SIZE_MAX - sizeof(alloc__header)) return NULL;
+
+    alloc__header *old = (alloc__header *)ptr - 1;
+    alloc__header saved = *old;
+    alloc__header *head = realloc(old, sizeof(*head) + size);
+    if (!head) return NULL;
+
+    // A realloc moves the block to whoever is running now
+    alloc__untrack(&saved, true);
+    return alloc__track(head, family, size, true);
+}
+
+static inline void alloc_stats_free(void *ptr)
+{
+    if (!ptr) return;
+
+    alloc__header *head = (alloc__header *)ptr - 1;
+    alloc__untrack(head, false);
+    free(head);
+}
+
+static inline char *alloc_stats_strdup(int family, const char *s)
+{
+    size_t size = strlen(s) + 1;
+    char *copy = alloc_stats_malloc(family, size);
+    if (copy) memcpy(copy, s, size);
+    return copy;
+}
+
+static inline void alloc__print_row(FILE *out, const char *name, const struct alloc_counters *c)
+{
+    fprintf(out, "%-8s %10zu %10zu %10zu %14zu %14zu %12zu\n", name,
+            atomic_load(&c->allocs), atomic_load(&c->reallocs), atomic_load(&c->frees),
+            atomic_load(&c->bytes), atomic_load(&c->peak), atomic_load(&c->live));
+}
+
+// Print the counters of one stats block, one row per family.
+static inline void alloc_stats_print(FILE *out, const struct alloc_stats *stats)
+{
+    fprintf(out, "%-8s %10s %10s %10s %14s %14s %12s\n", "family",
+            "allocs", "reallocs", "frees", "bytes", "peak live", "still live");
+    for (size_t i = 0; i < ALLOC_FAMILIES; i++)
+        if (atomic_load(&stats->family[i].allocs) > 0)
+            alloc__print_row(out, alloc_family_names[i], &stats->family[i]);
+    alloc__print_row(out, "total", &stats->total);
+}
+
+static inline void alloc_stats_print_header(FILE *out)
+{
+    fprintf(out, "%-10s %10s %14s %14s", "solver", "allocs", "bytes", "peak live");
+    for (size_t i = 0; i < ALLOC_FAMILIES; i++)
+        fprintf(out, " %8s", alloc_family_names[i]);
+    fprintf(out, "\n");
+}
+
+// Print one summary line for a solver: totals, then allocations per family.
+static inline void alloc_stats_print_line(FILE *out, const char *label, const struct alloc_stats *stats)
+{
+    fprintf(out, "%-10s %10zu %14zu %14zu", label, atomic_load(&stats->total.allocs),
+            atomic_load(&stats->total.bytes), atomic_load(&stats->total.peak));
+    for (size_t i = 0; i < ALLOC_FAMILIES; i++)
+        fprintf(out, " %8zu", atomic_load(&stats->family[i].allocs));
+    fprintf(out, "\n");
+}
+
+#define RAX_DA_REALLOC(PTR, SIZE)   alloc_stats_realloc(ALLOC_DA, (PTR), (SIZE))
+#define RAX_DA_FREE(PTR)            alloc_stats_free(PTR)
+#define RAX_HT_MALLOC(SIZE)         alloc_stats_malloc(ALLOC_HT, (SIZE))
+#define RAX_HT_CALLOC(N, SIZE)      alloc_stats_calloc(ALLOC_HT, (N), (SIZE))
+#define RAX_HT_REALLOC(PTR, SIZE)   alloc_stats_realloc(ALLOC_HT, (PTR), (SIZE))
+#define RAX_HT_FREE(PTR)            alloc_stats_free(PTR)
+#define RAX_HSET_MALLOC(SIZE)       alloc_stats_malloc(ALLOC_HSET, (SIZE))
+#define RAX_HSET_CALLOC(N, SIZE)    alloc_stats_calloc(ALLOC_HSET, (N), (SIZE))
+#define RAX_HSET_REALLOC(PTR, SIZE) alloc_stats_realloc(ALLOC_HSET, (PTR), (SIZE))
+#define RAX_HSET_FREE(PTR)          alloc_stats_free(PTR)
+#define RAX_STRV_MALLOC(SIZE)       alloc_stats_malloc(ALLOC_STRV, (SIZE))
+
+// Everything else. Defined last, so the wrappers above still reach libc.
+#define malloc(SIZE)                alloc_stats_malloc(ALLOC_LIBC, (SIZE))
+#define calloc(N, SIZE)             alloc_stats_calloc(ALLOC_LIBC, (N), (SIZE))
+#define realloc(PTR, SIZE)          alloc_stats_realloc(ALLOC_LIBC, (PTR), (SIZE))
+#define free(PTR)                   alloc_stats_free(PTR)
+#define strdup(S)                   alloc_stats_strdup(ALLOC_LIBC, (S))
+
+#else
+
+struct alloc_stats {
+    char unused;
+};
+
+#define alloc_stats_begin(STATS) ((void)(STATS), (struct alloc_stats *)NULL)
+#define alloc_stats_end(PREV) ((void)(PREV))
+#define alloc_stats_current() ((struct alloc_stats *)NULL)
+
+#endif // ALLOC_STATS
+
+#endif // ALLOC_STATS_H
@@ -0,0 +1,442 @@
+#ifndef MD5_H
+#define MD5_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MD5_X86
+#include <immintrin.h>
+#endif
+
+// MD5 (RFC 1321).
+//
+// unsigned char digest[MD5_DIGEST_SIZE];
+// md5(digest, data, size);
+//
+// or incrementally:
+//
+// struct md5 ctx;
+// md5_init(&ctx);
+// md5_update(&ctx, data, size);
+// md5_final(&ctx, digest);
+//
+// For brute force searches over many short messages there are also
+// multi-lane kernels that compress several independent blocks at once,
+// see struct md5_kernel below.
+
+#define MD5_BLOCK_SIZE  64
+#define MD5_DIGEST_SIZE 16
+
+struct md5 {
+    uint32_t state[4];
+    uint64_t size; // Total bytes hashed so far
+    unsigned char buf[MD5_BLOCK_SIZE];
+};
+
+static const uint32_t md5_init_state[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+
+static inline uint32_t md5_rotl(uint32_t x, int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+static inline uint32_t md5_load_word(const unsigned char *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Read the 16 little endian message words of a block
+static inline void md5_load_block(uint32_t m[16], const unsigned char *block)
+{
+    for (int i = 0; i < 16; i++)
+        m[i] = md5_load_word(block + i * 4);
+}
+
+#define MD5__FF(X, Y, Z) ((Z) ^ ((X) & ((Y) ^ (Z))))
+#define MD5__GG(X, Y, Z) ((Y) ^ ((Z) & ((X) ^ (Y))))
+#define MD5__HH(X, Y, Z) ((X) ^ (Y) ^ (Z))
+#define MD5__II(X, Y, Z) ((Y) ^ ((X) | ~(Z)))
+
+#define MD5__STEP(F, A, B, C, D, M, K, R) \
+    (A) = (B) + md5_rotl((A) + F((B), (C), (D)) + (M) + (K), (R))
+
+// All 64 steps, written out so every word index and constant is an
+// immediate. STEP(F, A, B, C, D, I, K, R) gets the round function name
+// (FF, GG, HH or II), the rotated state variables, the message word
+// index, the additive constant and the rotation.
+#define MD5__ROUNDS(STEP)                                   \
+    STEP(FF, a, b, c, d,  0, 0xd76aa478,  7)                \
+    STEP(FF, d, a, b, c,  1, 0xe8c7b756, 12)                \
+    STEP(FF, c, d, a, b,  2, 0x242070db, 17)                \
+    STEP(FF, b, c, d, a,  3, 0xc1bdceee, 22)                \
+    STEP(FF, a, b, c, d,  4, 0xf57c0faf,  7)                \
+    STEP(FF, d, a, b, c,  5, 0x4787c62a, 12)                \
+    STEP(FF, c, d, a, b,  6, 0xa8304613, 17)                \
+    STEP(FF, b, c, d, a,  7, 0xfd469501, 22)                \
+    STEP(FF, a, b, c, d,  8, 0x698098d8,  7)                \
+    STEP(FF, d, a, b, c,  9, 0x8b44f7af, 12)                \
+    STEP(FF, c, d, a, b, 10, 0xffff5bb1, 17)                \
+    STEP(FF, b, c, d, a, 11, 0x895cd7be, 22)                \
+    STEP(FF, a, b, c, d, 12, 0x6b901122,  7)                \
+    STEP(FF, d, a, b, c, 13, 0xfd987193, 12)                \
+    STEP(FF, c, d, a, b, 14, 0xa679438e, 17)                \
+    STEP(FF, b, c, d, a, 15, 0x49b40821, 22)                \
+                                                            \
+    STEP(GG, a, b, c, d,  1, 0xf61e2562,  5)                \
+    STEP(GG, d, a, b, c,  6, 0xc040b340,  9)                \
+    STEP(GG, c, d, a, b, 11, 0x265e5a51, 14)                \
+    STEP(GG, b, c, d, a,  0, 0xe9b6c7aa, 20)                \
+    STEP(GG, a, b, c, d,  5, 0xd62f105d,  5)                \
+    STEP(GG, d, a, b, c, 10, 0x02441453,  9)                \
+    STEP(GG, c, d, a, b, 15, 0xd8a1e681, 14)                \
+    STEP(GG, b, c, d, a,  4, 0xe7d3fbc8, 20)                \
+    STEP(GG, a, b, c, d,  9, 0x21e1cde6,  5)                \
+    STEP(GG, d, a, b, c, 14, 0xc33707d6,  9)                \
+    STEP(GG, c, d, a, b,  3, 0xf4d50d87, 14)                \
+    STEP(GG, b, c, d, a,  8, 0x455a14ed, 20)                \
+    STEP(GG, a, b, c, d, 13, 0xa9e3e905,  5)                \
+    STEP(GG, d, a, b, c,  2, 0xfcefa3f8,  9)                \
+    STEP(GG, c, d, a, b,  7, 0x676f02d9, 14)                \
+    STEP(GG, b, c, d, a, 12, 0x8d2a4c8a, 20)                \
+                                                            \
+    STEP(HH, a, b, c, d,  5, 0xfffa3942,  4)                \
+    STEP(HH, d, a, b, c,  8, 0x8771f681, 11)                \
+    STEP(HH, c, d, a, b, 11, 0x6d9d6122, 16)                \
+    STEP(HH, b, c, d, a, 14, 0xfde5380c, 23)                \
+    STEP(HH, a, b, c, d,  1, 0xa4beea44,  4)                \
+    STEP(HH, d, a, b, c,  4, 0x4bdecfa9, 11)                \
+    STEP(HH, c, d, a, b,  7, 0xf6bb4b60, 16)                \
+    STEP(HH, b, c, d, a, 10, 0xbebfbc70, 23)                \
+    STEP(HH, a, b, c, d, 13, 0x289b7ec6,  4)                \
+    STEP(HH, d, a, b, c,  0, 0xeaa127fa, 11)                \
+    STEP(HH, c, d, a, b,  3, 0xd4ef3085, 16)                \
+    STEP(HH, b, c, d, a,  6, 0x04881d05, 23)                \
+    STEP(HH, a, b, c, d,  9, 0xd9d4d039,  4)                \
+    STEP(HH, d, a, b, c, 12, 0xe6db99e5, 11)                \
+    STEP(HH, c, d, a, b, 15, 0x1fa27cf8, 16)                \
+    STEP(HH, b, c, d, a,  2, 0xc4ac5665, 23)                \
+                                                            \
+    STEP(II, a, b, c, d,  0, 0xf4292244,  6)                \
+    STEP(II, d, a, b, c,  7, 0x432aff97, 10)                \
+    STEP(II, c, d, a, b, 14, 0xab9423a7, 15)                \
+    STEP(II, b, c, d, a,  5, 0xfc93a039, 21)                \
+    STEP(II, a, b, c, d, 12, 0x655b59c3,  6)                \
+    STEP(II, d, a, b, c,  3, 0x8f0ccc92, 10)                \
+    STEP(II, c, d, a, b, 10, 0xffeff47d, 15)                \
+    STEP(II, b, c, d, a,  1, 0x85845dd1, 21)                \
+    STEP(II, a, b, c, d,  8, 0x6fa87e4f,  6)                \
+    STEP(II, d, a, b, c, 15, 0xfe2ce6e0, 10)                \
+    STEP(II, c, d, a, b,  6, 0xa3014314, 15)                \
+    STEP(II, b, c, d, a, 13, 0x4e0811a1, 21)                \
+    STEP(II, a, b, c, d,  4, 0xf7537e82,  6)                \
+    STEP(II, d, a, b, c, 11, 0xbd3af235, 10)                \
+    STEP(II, c, d, a, b,  2, 0x2ad7d2bb, 15)                \
+    STEP(II, b, c, d, a,  9, 0xeb86d391, 21)
+
+#define MD5__SCALAR_STEP(F, A, B, C, D, I, K, R) \
+    MD5__STEP(MD5__##F, A, B, C, D, m[I], K, R);
+
+// Run the compression function over 16 message words
+static inline void md5_compress_words(uint32_t state[4], const uint32_t m[16])
+{
+    uint32_t a = state[0];
+    uint32_t b = state[1];
+    uint32_t c = state[2];
+    uint32_t d = state[3];
+
+    MD5__ROUNDS(MD5__SCALAR_STEP)
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+}
+
+// Run the compression function over one 64 byte block
+void md5_compress(uint32_t state[4], const unsigned char *block)
+{
+    uint32_t m[16];
+    md5_load_block(m, block);
+    md5_compress_words(state, m);
+}
+
+void md5_init(struct md5 *ctx)
+{
+    memcpy(ctx->state, md5_init_state, sizeof(ctx->state));
+    ctx->size = 0;
+}
+
+void md5_update(struct md5 *ctx, const void *data, size_t size)
+{
+    const unsigned char *p = data;
+    size_t used = ctx->size % MD5_BLOCK_SIZE;
+    ctx->size += size;
+
+    if (used > 0) {
+        size_t n = MD5_BLOCK_SIZE - used;
+        if (n > size) n = size;
+
+        memcpy(ctx->buf + used, p, n);
+        p += n;
+        size -= n;
+        if (used + n < MD5_BLOCK_SIZE) return;
+
+        md5_compress(ctx->state, ctx->buf);
+    }
+
+    for (; size >= MD5_BLOCK_SIZE; p += MD5_BLOCK_SIZE, size -= MD5_BLOCK_SIZE)
+        md5_compress(ctx->state, p);
+
+    memcpy(ctx->buf, p, size);
+}
+
+// Write the digest for everything hashed so far
+void md5_final(struct md5 *ctx, unsigned char digest[MD5_DIGEST_SIZE])
+{
+    uint64_t bits = ctx->size * 8;
+    size_t used = ctx->size % MD5_BLOCK_SIZE;
+
+    // 0x80, zeros up to 56 mod 64, then the bit length
+    ctx->buf[used++] = 0x80;
+    if (used > 56) {
+        memset(ctx->buf + used, 0, MD5_BLOCK_SIZE - used);
+        md5_compress(ctx->state, ctx->buf);
+        used = 0;
+    }
+    memset(ctx->buf + used, 0, 56 - used);
+    for (int i = 0; i < 8; i++)
+        ctx->buf[56 + i] = (unsigned char)(bits >> (8 * i));
+    md5_compress(ctx->state, ctx->buf);
+
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            digest[i * 4 + j] = (unsigned char)(ctx->state[i] >> (8 * j));
+}
+
+void md5(unsigned char digest[MD5_DIGEST_SIZE], const void *data, size_t size)
+{
+    struct md5 ctx;
+    md5_init(&ctx);
+    md5_update(&ctx, data, size);
+    md5_final(&ctx, digest);
+}
+
+// Pad the last `used` bytes of a message of total_size bytes, already
+// at the start of block, into the final block. Only valid for
+// used <= MD5_MAX_SINGLE_BLOCK.
+#define MD5_MAX_SINGLE_BLOCK 55
+void md5_pad_final_block(unsigned char block[MD5_BLOCK_SIZE], size_t used, uint64_t total_size)
+{
+    uint64_t bits = total_size * 8;
+    block[used] = 0x80;
+    memset(block + used + 1, 0, 56 - used - 1);
+    for (int i = 0; i < 8; i++)
+        block[56 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+// Pad a whole message of size bytes into a single block
+void md5_pad_block(unsigned char block[MD5_BLOCK_SIZE], size_t size)
+{
+    md5_pad_final_block(block, size, size);
+}
+
+// Multi-lane kernels compress `lanes` independent blocks starting from
+// the same state. Words are interleaved by lane: message word w of lane
+// l is m[w * lanes + l], and state word w of lane l ends up in
+// out[w * lanes + l]. The state words are the digest in little endian.
+// compress_lanes starts each lane from its own state, interleaved the
+// same way as out, so a second block can follow the first.
+#define MD5_MAX_LANES 8
+
+struct md5_kernel {
+    const char *name;
+    size_t lanes;
+    void (*compress)(uint32_t *out, const uint32_t state[4], const uint32_t *m);
+    void (*compress_lanes)(uint32_t *out, const uint32_t *states, const uint32_t *m);
+    bool (*supported)(void);
+};
+
+bool md5_always_supported(void)
+{
+    return true;
+}
+
+void md5_compress_x1(uint32_t *out, const uint32_t state[4], const uint32_t *m)
+{
+    memcpy(out, state, 4 * sizeof(*out));
+    md5_compress_words(out, m);
+}
+
+void md5_compress_lanes_x1(uint32_t *out, const uint32_t *states, const uint32_t *m)
+{
+    md5_compress_x1(out, states, m);
+}
+
+#ifdef MD5_X86
+
+// The vector kernels share one step macro. Each kernel defines the
+// MD5__V* operations for its register width before using it.
+#define MD5__VFF(X, Y, Z) MD5__VXOR((Z), MD5__VAND((X), MD5__VXOR((Y), (Z))))
+#define MD5__VGG(X, Y, Z) MD5__VXOR((Y), MD5__VAND((Z), MD5__VXOR((X), (Y))))
+#define MD5__VHH(X, Y, Z) MD5__VXOR(MD5__VXOR((X), (Y)), (Z))
+#define MD5__VII(X, Y, Z) MD5__VXOR((Y), MD5__VOR((X), MD5__VXOR((Z), ones)))
+#define MD5__VROTL(X, R) MD5__VOR(MD5__VSLL((X), (R)), MD5__VSRL((X), 32 - (R)))
+#define MD5__VECTOR_STEP(F, A, B, C, D, I, K, R)                            \
+    (A) = MD5__VADD((B), MD5__VROTL(MD5__VADD(MD5__VADD((A), MD5__V##F((B), (C), (D))), \
+                                              MD5__VADD(w[I], MD5__VSET1((int)(K)))), (R)));
+
+#define MD5__VADD  _mm_add_epi32
+#define MD5__VAND  _mm_and_si128
+#define MD5__VOR   _mm_or_si128
+#define MD5__VXOR  _mm_xor_si128
+#define MD5__VSLL  _mm_slli_epi32
+#define MD5__VSRL  _mm_srli_epi32
+#define MD5__VSET1 _mm_set1_epi32
+
+__attribute__((target("sse2")))
+void md5_compress_x4_sse2(uint32_t *out, const uint32_t state[4], const uint32_t *m)
+{
+    __m128i w[16];
+    for (int i = 0; i < 16; i++)
+        w[i] = _mm_loadu_si128((const __m128i *)(m + 4 * i));
+
+    const __m128i ones = _mm_set1_epi32(-1);
+    __m128i a = _mm_set1_epi32((int)state[0]);
+    __m128i b = _mm_set1_epi32((int)state[1]);
+    __m128i c = _mm_set1_epi32((int)state[2]);
+    __m128i d = _mm_set1_epi32((int)state[3]);
+
+    MD5__ROUNDS(MD5__VECTOR_STEP)
+
+    _mm_storeu_si128((__m128i *)(out + 0), _mm_add_epi32(a, _mm_set1_epi32((int)state[0])));
+    _mm_storeu_si128((__m128i *)(out + 4), _mm_add_epi32(b, _mm_set1_epi32((int)state[1])));
+    _mm_storeu_si128((__m128i *)(out + 8), _mm_add_epi32(c, _mm_set1_epi32((int)state[2])));
+    _mm_storeu_si128((__m128i *)(out + 12), _mm_add_epi32(d, _mm_set1_epi32((int)state[3])));
+}
+
+__attribute__((target("sse2")))
+void md5_compress_lanes_x4_sse2(uint32_t *out, const uint32_t *states, const uint32_t *m)
+{
+    __m128i w[16];
+    for (int i = 0; i < 16; i++)
+        w[i] = _mm_loadu_si128((const __m128i *)(m + 4 * i));
+
+    const __m128i ones = _mm_set1_epi32(-1);
+    const __m128i a0 = _mm_loadu_si128((const __m128i *)(states + 0));
+    const __m128i b0 = _mm_loadu_si128((const __m128i *)(states + 4));
+    const __m128i c0 = _mm_loadu_si128((const __m128i *)(states + 8));
+    const __m128i d0 = _mm_loadu_si128((const __m128i *)(states + 12));
+    __m128i a = a0, b = b0, c = c0, d = d0;
+
+    MD5__ROUNDS(MD5__VECTOR_STEP)
+
+    _mm_storeu_si128((__m128i *)(out + 0), _mm_add_epi32(a, a0));
+    _mm_storeu_si128((__m128i *)(out + 4), _mm_add_epi32(b, b0));
+    _mm_storeu_si128((__m128i *)(out + 8), _mm_add_epi32(c, c0));
+    _mm_storeu_si128((__m128i *)(out + 12), _mm_add_epi32(d, d0));
+}
+
+#undef MD5__VADD
+#undef MD5__VAND
+#undef MD5__VOR
+#undef MD5__VXOR
+#undef MD5__VSLL
+#undef MD5__VSRL
+#undef MD5__VSET1
+
+#define MD5__VADD  _mm256_add_epi32
+#define MD5__VAND  _mm256_and_si256
+#define MD5__VOR   _mm256_or_si256
+#define MD5__VXOR  _mm256_xor_si256
+#define MD5__VSLL  _mm256_slli_epi32
+#define MD5__VSRL  _mm256_srli_epi32
+#define MD5__VSET1 _mm256_set1_epi32
+
+__attribute__((target("avx2")))
+void md5_compress_x8_avx2(uint32_t *out, const uint32_t state[4], const uint32_t *m)
+{
+    __m256i w[16];
+    for (int i = 0; i < 16; i++)
+        w[i] = _mm256_loadu_si256((const __m256i *)(m + 8 * i));
+
+    const __m256i ones = _mm256_set1_epi32(-1);
+    __m256i a = _mm256_set1_epi32((int)state[0]);
+    __m256i b = _mm256_set1_epi32((int)state[1]);
+    __m256i c = _mm256_set1_epi32((int)state[2]);
+    __m256i d = _mm256_set1_epi32((int)state[3]);
+
+    MD5__ROUNDS(MD5__VECTOR_STEP)
+
+    _mm256_storeu_si256((__m256i *)(out + 0), _mm256_add_epi32(a, _mm256_set1_epi32((int)state[0])));
+    _mm256_storeu_si256((__m256i *)(out + 8), _mm256_add_epi32(b, _mm256_set1_epi32((int)state[1])));
+    _mm256_storeu_si256((__m256i *)(out + 16), _mm256_add_epi32(c, _mm256_set1_epi32((int)state[2])));
+    _mm256_storeu_si256((__m256i *)(out + 24), _mm256_add_epi32(d, _mm256_set1_epi32((int)state[3])));
+}
+
+__attribute__((target("avx2")))
+void md5_compress_lanes_x8_avx2(uint32_t *out, const uint32_t *states, const uint32_t *m)
+{
+    __m256i w[16];
+    for (int i = 0; i < 16; i++)
+        w[i] = _mm256_loadu_si256((const __m256i *)(m + 8 * i));
+
+    const __m256i ones = _mm256_set1_epi32(-1);
+    const __m256i a0 = _mm256_loadu_si256((const __m256i *)(states + 0));
+    const __m256i b0 = _mm256_loadu_si256((const __m256i *)(states + 8));
+    const __m256i c0 = _mm256_loadu_si256((const __m256i *)(states + 16));
+    const __m256i d0 = _mm256_loadu_si256((const __m256i *)(states + 24));
+    __m256i a = a0, b = b0, c = c0, d = d0;
+
+    MD5__ROUNDS(MD5__VECTOR_STEP)
+
+    _mm256_storeu_si256((__m256i *)(out + 0), _mm256_add_epi32(a, a0));
+    _mm256_storeu_si256((__m256i *)(out + 8), _mm256_add_epi32(b, b0));
+    _mm256_storeu_si256((__m256i *)(out + 16), _mm256_add_epi32(c, c0));
+    _mm256_storeu_si256((__m256i *)(out + 24), _mm256_add_epi32(d, d0));
+}
+
+#undef MD5__VADD
+#undef MD5__VAND
+#undef MD5__VOR
+#undef MD5__VXOR
+#undef MD5__VSLL
+#undef MD5__VSRL
+#undef MD5__VSET1
+
+bool md5_sse2_supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+}
+
+bool md5_avx2_supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif // MD5_X86
+
+// Widest first
+const struct md5_kernel md5_kernels[] = {
+#ifdef MD5_X86
+    {"avx2", 8, md5_compress_x8_avx2, md5_compress_lanes_x8_avx2, md5_avx2_supported},
+    {"sse2", 4, md5_compress_x4_sse2, md5_compress_lanes_x4_sse2, md5_sse2_supported},
+#endif
+    {"scalar", 1, md5_compress_x1, md5_compress_lanes_x1, md5_always_supported},
+};
+
+// The widest kernel this CPU can run
+const struct md5_kernel *md5_best_kernel(void)
+{
+    size_t n = sizeof(md5_kernels) / sizeof(md5_kernels[0]);
+    for (size_t i = 0; i < n; i++)
+        if (md5_kernels[i].supported())
+            return &md5_kernels[i];
+
+    return &md5_kernels[n - 1];
+}
+
+#endif // MD5_H
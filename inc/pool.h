@@ -0,0 +1,174 @@
+#ifndef POOL_H
+#define POOL_H
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "alloc_stats.h"
+
+// Fixed-size worker pool with a FIFO job queue.
+//
+// struct pool pool = {0};
+// pool_init(&pool, 4, 0);
+// pool_submit(&pool, fn, arg);
+// pool_wait(&pool);
+// pool_destroy(&pool);
+
+// Worker stack size. 0 keeps the pthread default, which is plenty: no
+// solver keeps more than a few tens of KB on the stack.
+#ifndef POOL_STACK_SIZE
+#define POOL_STACK_SIZE 0
+#endif
+
+typedef void (*pool_fn)(void *arg);
+
+struct pool_job {
+    pool_fn fn;
+    void *arg;
+    struct alloc_stats *alloc; // Stats block of the submitter
+    struct pool_job *next;
+};
+
+struct pool {
+    pthread_t *threads;
+    size_t n_threads;
+
+    pthread_mutex_t lock;
+    pthread_cond_t has_work;
+    pthread_cond_t done;
+
+    struct pool_job *head;
+    struct pool_job *tail;
+    size_t in_flight; // queued + running
+    bool stop;
+};
+
+// Number of online CPUs, at least 1
+size_t pool_default_threads(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t)n : 1;
+}
+
+void *pool__worker(void *arg)
+{
+    struct pool *pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+        while (!pool->head && !pool->stop)
+            pthread_cond_wait(&pool->has_work, &pool->lock);
+
+        if (!pool->head && pool->stop)
+            break;
+
+        struct pool_job *job = pool->head;
+        pool->head = job->next;
+        if (!pool->head)
+            pool->tail = NULL;
+
+        pthread_mutex_unlock(&pool->lock);
+        struct alloc_stats *prev = alloc_stats_begin(job->alloc);
+        job->fn(job->arg);
+        alloc_stats_end(prev);
+        free(job);
+        pthread_mutex_lock(&pool->lock);
+
+        if (--pool->in_flight == 0)
+            pthread_cond_broadcast(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+// Start n_threads workers. A stack_size of 0 uses POOL_STACK_SIZE.
+// Return false if no worker could be started.
+bool pool_init(struct pool *pool, size_t n_threads, size_t stack_size)
+{
+    memset(pool, 0, sizeof(*pool));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->has_work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    pool->threads = malloc(sizeof(*pool->threads) * n_threads);
+    if (!pool->threads) {
+        perror("OOM");
+        return false;
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (!stack_size) stack_size = POOL_STACK_SIZE;
+    if (stack_size) pthread_attr_setstacksize(&attr, stack_size);
+
+    for (size_t i = 0; i < n_threads; i++) {
+        if (pthread_create(&pool->threads[i], &attr, pool__worker, pool) != 0) {
+            perror("Failed to start worker thread");
+            break;
+        }
+
+        pool->n_threads++;
+    }
+
+    pthread_attr_destroy(&attr);
+    return pool->n_threads > 0;
+}
+
+// Queue a job. Return false if memory allocation fails.
+bool pool_submit(struct pool *pool, pool_fn fn, void *arg)
+{
+    struct pool_job *job = malloc(sizeof(*job));
+    if (!job) {
+        perror("OOM");
+        return false;
+    }
+
+    job->fn = fn;
+    job->arg = arg;
+    job->alloc = alloc_stats_current();
+    job->next = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->tail)
+        pool->tail->next = job;
+    else
+        pool->head = job;
+    pool->tail = job;
+    pool->in_flight++;
+    pthread_cond_signal(&pool->has_work);
+    pthread_mutex_unlock(&pool->lock);
+
+    return true;
+}
+
+// Block until every submitted job has finished.
+void pool_wait(struct pool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (pool->in_flight > 0)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Finish all queued jobs, then stop and join the workers.
+void pool_destroy(struct pool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->has_work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->n_threads; i++)
+        pthread_join(pool->threads[i], NULL);
+
+    free(pool->threads);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->has_work);
+    pthread_cond_destroy(&pool->done);
+    memset(pool, 0, sizeof(*pool));
+}
+
+#endif // POOL_H
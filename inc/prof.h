@@ -0,0 +1,181 @@
+#ifndef PROF_H
+#define PROF_H
+
+// Lightweight phase profiler.
+//
+// Build with -DPROF to enable. Without it every macro below expands to
+// nothing, so instrumented code pays no cost.
+//
+// void solve(void)
+// {
+//     PROF_ZONE("solve");          // Ends when the enclosing scope exits
+//     ...
+//     PROF_BEGIN(parse, "parse");  // Explicit begin/end for phases that
+//     ...                          // don't line up with a scope
+//     PROF_END(parse);
+// }
+//
+// Zone names must be string literals (or otherwise outlive the profiler).
+
+#ifdef PROF
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+struct prof_zone {
+    const char *name;
+    uint64_t start;
+};
+
+struct prof_event {
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+    int tid;
+};
+
+static struct {
+    pthread_mutex_t lock;
+    struct prof_event *events;
+    size_t size;
+    size_t cap;
+    int next_tid;
+} prof__state = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static _Thread_local int prof__tid = -1;
+
+#define PROF__JOIN2(X, Y) X##Y
+#define PROF__JOIN(X, Y) PROF__JOIN2(X, Y)
+
+#define PROF_ZONE(NAME) \
+    struct prof_zone PROF__JOIN(prof__zone_, __LINE__) __attribute__((cleanup(prof__zone_end))) = prof__zone_begin(NAME)
+#define PROF_BEGIN(VAR, NAME) struct prof_zone VAR = prof__zone_begin(NAME)
+#define PROF_END(VAR) prof__zone_end(&(VAR))
+
+static inline struct prof_zone prof__zone_begin(const char *name)
+{
+    return (struct prof_zone) { .name = name, .start = now_ns() };
+}
+
+static inline void prof__zone_end(struct prof_zone *zone)
+{
+    uint64_t end = now_ns();
+
+    pthread_mutex_lock(&prof__state.lock);
+    if (prof__tid < 0)
+        prof__tid = prof__state.next_tid++;
+
+    if (prof__state.size == prof__state.cap) {
+        size_t new_cap = prof__state.cap ? prof__state.cap * 2 : 256;
+        struct prof_event *new_events = realloc(prof__state.events, new_cap * sizeof(*new_events));
+        if (!new_events) {
+            pthread_mutex_unlock(&prof__state.lock);
+            return;
+        }
+
+        prof__state.events = new_events;
+        prof__state.cap = new_cap;
+    }
+
+    prof__state.events[prof__state.size++] = (struct prof_event) {
+        .name = zone->name,
+        .start = zone->start,
+        .end = end,
+        .tid = prof__tid,
+    };
+    pthread_mutex_unlock(&prof__state.lock);
+}
+
+// Drop all recorded events
+static inline void prof_reset(void)
+{
+    pthread_mutex_lock(&prof__state.lock);
+    prof__state.size = 0;
+    pthread_mutex_unlock(&prof__state.lock);
+}
+
+// Print calls, total and mean time per zone name, in order of first use
+static inline void prof_print_summary(FILE *out)
+{
+    pthread_mutex_lock(&prof__state.lock);
+
+    struct prof_event *events = prof__state.events;
+    size_t n = prof__state.size;
+    bool *done = calloc(n ? n : 1, sizeof(*done));
+    if (!done) {
+        pthread_mutex_unlock(&prof__state.lock);
+        return;
+    }
+
+    fprintf(out, "%-28s %8s %14s %14s\n", "zone", "calls", "total (ms)", "mean (us)");
+    for (size_t i = 0; i < n; i++) {
+        if (done[i]) continue;
+
+        size_t calls = 0;
+        uint64_t total = 0;
+        for (size_t j = i; j < n; j++) {
+            if (done[j] || strcmp(events[i].name, events[j].name) != 0) continue;
+
+            done[j] = true;
+            calls++;
+            total += events[j].end - events[j].start;
+        }
+
+        fprintf(out, "%-28s %8zu %14.3f %14.3f\n", events[i].name, calls,
+                (double)total / 1e6, (double)total / 1e3 / (double)calls);
+    }
+
+    free(done);
+    pthread_mutex_unlock(&prof__state.lock);
+}
+
+// Write all events in the Chrome trace event format, for
+// chrome://tracing or https://ui.perfetto.dev
+// Return false if the file cannot be written.
+static inline bool prof_write_trace(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        perror("Failed to open trace file");
+        return false;
+    }
+
+    pthread_mutex_lock(&prof__state.lock);
+    uint64_t origin = prof__state.size ? prof__state.events[0].start : 0;
+    for (size_t i = 0; i < prof__state.size; i++)
+        if (prof__state.events[i].start < origin)
+            origin = prof__state.events[i].start;
+
+    fprintf(file, "{\"traceEvents\": [\n");
+    for (size_t i = 0; i < prof__state.size; i++) {
+        const struct prof_event *e = &prof__state.events[i];
+        fprintf(file, "  {\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                "\"ts\": %.3f, \"dur\": %.3f}%s\n",
+                e->name, e->tid, (double)(e->start - origin) / 1e3,
+                (double)(e->end - e->start) / 1e3,
+                i + 1 < prof__state.size ? "," : "");
+    }
+    fprintf(file, "]}\n");
+    pthread_mutex_unlock(&prof__state.lock);
+
+    fclose(file);
+    return true;
+}
+
+#else
+
+#define PROF_ZONE(NAME)
+#define PROF_BEGIN(VAR, NAME)
+#define PROF_END(VAR)
+
+#define prof_reset()
+#define prof_print_summary(OUT)
+#define prof_write_trace(PATH) (fprintf(stderr, "Tracing needs a build with -DPROF\n"), false)
+
+#endif // PROF
+
+#endif // PROF_H
@@ -273,7 +273,7 @@ RAX_HSET_LINKAGE bool RAX_HSET_grow(RAX_HSET_NAME *hset)
     }
 
     if (hset->entries)
-        free(hset->entries);
+        RAX_HSET_FREE(hset->entries);
     hset->entries = new_entries;
     hset->capacity = new_cap;
     return true;
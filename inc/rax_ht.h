@@ -289,7 +289,7 @@ RAX_HT_LINKAGE bool RAX_HT_grow(RAX_HT_NAME *ht)
     }
 
     if (ht->entries)
-        free(ht->entries);
+        RAX_HT_FREE(ht->entries);
     ht->entries = new_entries;
     ht->capacity = new_cap;
     return true;
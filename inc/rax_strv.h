@@ -32,7 +32,9 @@
 #define RAX_STRV_MALLOC malloc
 #endif // RAX_STRV_MALLOC
 
-// Size of statically allocated buffer for creating temporary strings
+// Size of statically allocated buffer for creating temporary strings.
+// The buffer is thread-local, so temporary strings are only shared
+// within a thread.
 #ifndef RAX_STRV_TEMP_BUF_SIZE
 #define RAX_STRV_TEMP_BUF_SIZE 4096
 #endif // RAX_STRV_TEMP_BUF_SIZE
@@ -104,9 +106,9 @@ bool rax_strv_is_empty(rax_strv sv);
 // Return a string allocated with RAX_STRV_MALLOC
 char *rax_strv_to_cstr_owned(rax_strv sv);
 
-// Return a string allocated in the internal static buffer
+// Return a string allocated in the internal (thread-local) static buffer
 // String is transient and will be overwritten on another call to
-// rax_strv_*_temp
+// rax_strv_*_temp from the same thread
 char *rax_strv_to_cstr_temp(rax_strv sv);
 
 // Create an iterator that "splits" a string into string view slices
@@ -139,7 +141,7 @@ bool rax_strv_parse_long(rax_strv word, long *n);
 #include <string.h>
 #include <ctype.h>
 
-static char rax__strv_temp_buf[RAX_STRV_TEMP_BUF_SIZE];
+static _Thread_local char rax__strv_temp_buf[RAX_STRV_TEMP_BUF_SIZE];
 
 rax_strv rax_strv_from_range(const char *s, size_t start, size_t end)
 {
@@ -1,10 +1,33 @@
 #ifndef UTILS_H
 #define UTILS_H
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define SIZE(X) (sizeof(X) / sizeof(X[0]))
 #define BOOL_ARG(ARG) ((ARG) ? "true" : "false")
 
+// Monotonic wall clock in nanoseconds
+uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Path of the puzzle input for a given day
+void input_path(char *buf, size_t size, int day)
+{
+    snprintf(buf, size, "./inputs/day%02d.txt", day);
+}
+
 char *read_whole_file(const char *path)
 {
     FILE *file = fopen(path, "r");
@@ -38,5 +61,213 @@ fail:
     return NULL;
 }
 
+// Read everything from fd until EOF into a NUL-terminated heap
+// buffer. Works on pipes and other non-seekable files.
+char *read_whole_fd(int fd, size_t *size)
+{
+    size_t cap = 64 * 1024;
+    size_t len = 0;
+    char *buf = malloc(cap);
+    if (!buf) {
+        perror("OOM");
+        return NULL;
+    }
+
+    while (true) {
+        if (len + 1 >= cap) {
+            char *new_buf = realloc(buf, cap * 2);
+            if (!new_buf) {
+                perror("OOM");
+                free(buf);
+                return NULL;
+            }
+
+            buf = new_buf;
+            cap *= 2;
+        }
+
+        ssize_t n = read(fd, buf + len, cap - len - 1);
+        if (n == 0) break;
+        if (n < 0) {
+            perror("Failed to read file");
+            free(buf);
+            return NULL;
+        }
+
+        len += (size_t)n;
+    }
+
+    buf[len] = '\0';
+    if (size) *size = len;
+    return buf;
+}
+
+enum load_flags {
+    LOAD_NO_MMAP    = 1 << 0, // Always copy into a heap buffer
+    LOAD_POPULATE   = 1 << 1, // MAP_POPULATE: fault every page in up front
+    LOAD_SEQUENTIAL = 1 << 2, // madvise(MADV_SEQUENTIAL) for read-ahead
+};
+
+#define LOAD_DEFAULT LOAD_SEQUENTIAL
+
+struct input_file {
+    const char *data; // Always NUL-terminated
+    size_t size;
+    void *map;        // NULL when data is a heap buffer
+    size_t map_size;
+};
+
+// Load a whole input file, or stdin if path is "-".
+//
+// Regular files are memory-mapped read-only. Solvers expect a
+// NUL-terminated string, so the mapping is placed at the start of an
+// anonymous reservation one page larger than the file: the bytes past
+// EOF in the last file page are zero-filled by the kernel, and if the
+// file ends on a page boundary the extra anonymous page supplies the
+// NUL. Pipes and other special files fall back to read().
+//
+// Return false on failure.
+bool load_input(struct input_file *in, const char *path, int flags)
+{
+    memset(in, 0, sizeof(*in));
+
+    bool is_stdin = strcmp(path, "-") == 0;
+    int fd = is_stdin ? STDIN_FILENO : open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open file");
+        return false;
+    }
+
+    struct stat st;
+    if ((flags & LOAD_NO_MMAP) || fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        char *buf = read_whole_fd(fd, &in->size);
+        if (!is_stdin) close(fd);
+        in->data = buf;
+        return buf != NULL;
+    }
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t size = (size_t)st.st_size;
+    size_t file_pages = (size + page - 1) / page * page;
+    size_t map_size = file_pages + page;
+
+    char *map = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+        perror("Failed to reserve memory for file");
+        if (!is_stdin) close(fd);
+        return false;
+    }
+
+    if (size > 0) {
+        int mflags = MAP_PRIVATE | MAP_FIXED;
+#ifdef MAP_POPULATE
+        if (flags & LOAD_POPULATE) mflags |= MAP_POPULATE;
+#endif
+        if (mmap(map, size, PROT_READ, mflags, fd, 0) == MAP_FAILED) {
+            perror("Failed to map file");
+            munmap(map, map_size);
+            if (!is_stdin) close(fd);
+            return false;
+        }
+
+        if (flags & LOAD_SEQUENTIAL)
+            madvise(map, size, MADV_SEQUENTIAL);
+    }
+
+    if (!is_stdin) close(fd);
+    in->data = map;
+    in->size = size;
+    in->map = map;
+    in->map_size = map_size;
+    return true;
+}
+
+void unload_input(struct input_file *in)
+{
+    if (in->map)
+        munmap(in->map, in->map_size);
+    else
+        free((char *)in->data);
+
+    memset(in, 0, sizeof(*in));
+}
+
+// What a streaming solver's feed reports after each chunk
+enum stream_status {
+    STREAM_MORE,  // Keep feeding
+    STREAM_DONE,  // The answer is known, no more input is needed
+    STREAM_ERROR, // Out of memory, the answer would be wrong
+};
+
+// Splits a stream of chunks into lines, for solvers that consume their
+// input incrementally. Lines that lie entirely inside a chunk are passed
+// through without copying. A line that straddles chunks is collected in
+// the partial buffer, which is kept NUL-terminated. Like strv_lines, the
+// text after the last newline (possibly empty) is the final line.
+typedef void (*line_fn)(void *ctx, const char *line, size_t size);
+
+struct line_splitter {
+    char *partial;
+    size_t size;
+    size_t cap;
+};
+
+// Append bytes to the partial line. Return false if memory allocation fails.
+bool line_splitter__append(struct line_splitter *ls, const char *s, size_t size)
+{
+    if (ls->size + size + 1 > ls->cap) {
+        size_t new_cap = ls->cap ? ls->cap : 256;
+        while (ls->size + size + 1 > new_cap)
+            new_cap *= 2;
+
+        char *new_partial = realloc(ls->partial, new_cap);
+        if (!new_partial) {
+            perror("OOM");
+            return false;
+        }
+
+        ls->partial = new_partial;
+        ls->cap = new_cap;
+    }
+
+    memcpy(ls->partial + ls->size, s, size);
+    ls->size += size;
+    ls->partial[ls->size] = '\0';
+    return true;
+}
+
+// Call on_line for every line completed by chunk.
+// Return false if memory allocation fails.
+bool line_splitter_feed(struct line_splitter *ls, const char *chunk, size_t size,
+                        line_fn on_line, void *ctx)
+{
+    const char *end = chunk + size;
+    while (chunk < end) {
+        const char *nl = memchr(chunk, '\n', (size_t)(end - chunk));
+        if (!nl)
+            return line_splitter__append(ls, chunk, (size_t)(end - chunk));
+
+        if (ls->size > 0) {
+            if (!line_splitter__append(ls, chunk, (size_t)(nl - chunk)))
+                return false;
+            on_line(ctx, ls->partial, ls->size);
+            ls->size = 0;
+        } else {
+            on_line(ctx, chunk, (size_t)(nl - chunk));
+        }
+
+        chunk = nl + 1;
+    }
+
+    return true;
+}
+
+// Emit the final line and release the partial buffer.
+void line_splitter_finish(struct line_splitter *ls, line_fn on_line, void *ctx)
+{
+    on_line(ctx, ls->partial ? ls->partial : "", ls->size);
+    free(ls->partial);
+    memset(ls, 0, sizeof(*ls));
+}
 
 #endif // UTILS_H
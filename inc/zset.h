@@ -0,0 +1,195 @@
+#ifndef ZSET_H
+#define ZSET_H
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Hash set of 2D integer points.
+//
+// struct zset set = {0};
+// zset_add(&set, x, y);
+// zset_has(&set, x, y);
+// set.size;
+// zset_destroy(&set);
+//
+// A point is stored as its Morton (Z-order) code, x and y bits
+// interleaved, so points close in the plane get close keys. Slots are
+// picked by multiply-shift hashing and probed linearly. Keys and
+// occupancy live in separate arrays, the occupancy as one bit per
+// slot, so a probe touches one key line and one bitmap line.
+
+#ifndef ZSET_INIT_CAPACITY
+#define ZSET_INIT_CAPACITY 64 // Must be a power of 2
+#endif
+
+struct zset {
+    size_t size;
+    size_t capacity;
+    unsigned shift; // 64 - log2(capacity)
+    uint64_t *keys;
+    uint64_t *occupied;
+};
+
+// Spread the 32 bits of v to the even bits of the result
+uint64_t zset__spread(uint32_t v)
+{
+    uint64_t x = v;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8))  & 0x00FF00FF00FF00FFULL;
+    x = (x | (x << 4))  & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x << 2))  & 0x3333333333333333ULL;
+    x = (x | (x << 1))  & 0x5555555555555555ULL;
+    return x;
+}
+
+// Morton code of (x, y). The sign bit is flipped so that the order of
+// the codes follows the order of the coordinates across zero.
+uint64_t zset_key(int x, int y)
+{
+    return zset__spread((uint32_t)x ^ 0x80000000u)
+         | (zset__spread((uint32_t)y ^ 0x80000000u) << 1);
+}
+
+uint64_t zset_hash(uint64_t key)
+{
+    return key * 0x9E3779B97F4A7C15ULL;
+}
+
+static inline bool zset__is_occupied(const uint64_t *occupied, size_t i)
+{
+    return occupied[i / 64] >> (i % 64) & 1;
+}
+
+// Index of key, or of the free slot it would go in
+static inline size_t zset__find(const struct zset *set, uint64_t key, bool *found)
+{
+    size_t mask = set->capacity - 1;
+    size_t i = (size_t)(zset_hash(key) >> set->shift);
+    while (zset__is_occupied(set->occupied, i)) {
+        if (set->keys[i] == key) {
+            *found = true;
+            return i;
+        }
+        i = (i + 1) & mask;
+    }
+
+    *found = false;
+    return i;
+}
+
+static inline void zset__insert_new(struct zset *set, uint64_t key)
+{
+    bool found;
+    size_t i = zset__find(set, key, &found);
+    set->keys[i] = key;
+    set->occupied[i / 64] |= 1ULL << (i % 64);
+}
+
+// Rehash into new_cap slots (a power of 2, at least 64).
+// Return false if memory allocation fails.
+bool zset__resize(struct zset *set, size_t new_cap)
+{
+    struct zset grown = {
+        .size = set->size,
+        .capacity = new_cap,
+        .shift = 64 - (unsigned)__builtin_ctzll(new_cap),
+        .keys = malloc(new_cap * sizeof(uint64_t)),
+        .occupied = calloc(new_cap / 64, sizeof(uint64_t)),
+    };
+    if (!grown.keys || !grown.occupied) {
+        perror("zset__resize - allocation failed!");
+        free(grown.keys);
+        free(grown.occupied);
+        return false;
+    }
+
+    for (size_t w = 0; w < set->capacity / 64; w++) {
+        for (uint64_t bits = set->occupied[w]; bits; bits &= bits - 1)
+            zset__insert_new(&grown, set->keys[w * 64 + (size_t)__builtin_ctzll(bits)]);
+    }
+
+    free(set->keys);
+    free(set->occupied);
+    *set = grown;
+    return true;
+}
+
+// Make room for n keys in total, so adding them won't grow the set.
+// Return false if memory allocation fails.
+bool zset_reserve(struct zset *set, size_t n)
+{
+    size_t new_cap = set->capacity ? set->capacity : ZSET_INIT_CAPACITY;
+    while (n >= new_cap / 2)
+        new_cap *= 2;
+
+    if (new_cap == set->capacity)
+        return true;
+    return zset__resize(set, new_cap);
+}
+
+// Add a Morton key. Return false if memory allocation fails.
+bool zset_add_key(struct zset *set, uint64_t key)
+{
+    if (set->size >= set->capacity / 2 && !zset_reserve(set, set->size + 1))
+        return false;
+
+    bool found;
+    size_t i = zset__find(set, key, &found);
+    if (!found) {
+        set->keys[i] = key;
+        set->occupied[i / 64] |= 1ULL << (i % 64);
+        set->size++;
+    }
+    return true;
+}
+
+bool zset_add(struct zset *set, int x, int y)
+{
+    return zset_add_key(set, zset_key(x, y));
+}
+
+bool zset_has(const struct zset *set, int x, int y)
+{
+    if (set->capacity == 0) return false;
+
+    bool found;
+    zset__find(set, zset_key(x, y), &found);
+    return found;
+}
+
+// Add every key of src to dst, growing dst at most once, and empty src.
+// Return false if memory allocation fails, in which case both sets are untouched.
+bool zset_union(struct zset *dst, struct zset *src)
+{
+    if (!zset_reserve(dst, dst->size + src->size))
+        return false;
+
+    for (size_t w = 0; w < src->capacity / 64; w++) {
+        for (uint64_t bits = src->occupied[w]; bits; bits &= bits - 1) {
+            uint64_t key = src->keys[w * 64 + (size_t)__builtin_ctzll(bits)];
+            bool found;
+            size_t i = zset__find(dst, key, &found);
+            if (!found) {
+                dst->keys[i] = key;
+                dst->occupied[i / 64] |= 1ULL << (i % 64);
+                dst->size++;
+            }
+        }
+    }
+
+    free(src->keys);
+    free(src->occupied);
+    *src = (struct zset) {0};
+    return true;
+}
+
+void zset_destroy(struct zset *set)
+{
+    free(set->keys);
+    free(set->occupied);
+    *set = (struct zset) {0};
+}
+
+#endif // ZSET_H
@@ -0,0 +1,177 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "utils.h"
+
+// Benchmark mode: re-run a single solver on an already loaded input
+// buffer and report timing statistics. Loading the input is timed
+// separately so that it does not pollute the solver numbers.
+
+enum bench_format {
+    BENCH_TEXT = 0,
+    BENCH_JSON,
+    BENCH_CSV,
+};
+
+struct bench_opts {
+    size_t iters;
+    size_t warmup;
+    enum bench_format format;
+};
+
+struct bench_result {
+    int day;
+    int part;
+    size_t input_size;
+    uint64_t load_ns;
+    size_t iters;
+    long long answer;
+    uint64_t min_ns;
+    uint64_t median_ns;
+    uint64_t p99_ns;
+    uint64_t max_ns;
+    double mean_ns;
+};
+
+int bench_cmp_u64(const void *first, const void *second)
+{
+    uint64_t a = *(const uint64_t *)first;
+    uint64_t b = *(const uint64_t *)second;
+    return (a > b) - (a < b);
+}
+
+// Some solvers print their answer themselves. Point stdout at
+// /dev/null while benchmarking so that the terminal (and the cost of
+// writing to it) stays out of the measurements.
+// Return the saved stdout fd, or -1 if nothing was redirected.
+int bench_silence_stdout(void)
+{
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    if (saved < 0)
+        return -1;
+
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull < 0) {
+        close(saved);
+        return -1;
+    }
+
+    dup2(devnull, STDOUT_FILENO);
+    close(devnull);
+    return saved;
+}
+
+void bench_restore_stdout(int saved)
+{
+    if (saved < 0) return;
+
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+}
+
+// Sort samples and fill in the statistics of res from them.
+void bench_summarize(uint64_t *samples, size_t n, struct bench_result *res)
+{
+    qsort(samples, n, sizeof(*samples), bench_cmp_u64);
+
+    double total = 0;
+    for (size_t i = 0; i < n; i++)
+        total += (double)samples[i];
+
+    // Nearest-rank percentiles
+    size_t p99 = (n * 99 + 99) / 100;
+    res->iters = n;
+    res->min_ns = samples[0];
+    res->median_ns = samples[(n - 1) / 2];
+    res->p99_ns = samples[(p99 > 0 ? p99 : 1) - 1];
+    res->max_ns = samples[n - 1];
+    res->mean_ns = total / (double)n;
+}
+
+// Run f over input opts->warmup + opts->iters times, recording the
+// wall time of the measured iterations.
+// Return false if memory allocation fails.
+bool bench_run(long long (*f)(const char *), const char *input,
+               const struct bench_opts *opts, struct bench_result *res)
+{
+    uint64_t *samples = malloc(sizeof(*samples) * opts->iters);
+    if (!samples) {
+        perror("OOM");
+        return false;
+    }
+
+    int saved = bench_silence_stdout();
+    for (size_t i = 0; i < opts->warmup; i++)
+        res->answer = f(input);
+
+    for (size_t i = 0; i < opts->iters; i++) {
+        uint64_t start = now_ns();
+        res->answer = f(input);
+        samples[i] = now_ns() - start;
+    }
+    bench_restore_stdout(saved);
+
+    bench_summarize(samples, opts->iters, res);
+    free(samples);
+    return true;
+}
+
+double bench_ns_per_byte(const struct bench_result *res)
+{
+    if (res->input_size == 0) return 0;
+    return (double)res->median_ns / (double)res->input_size;
+}
+
+// MB/s based on the median run
+double bench_throughput(const struct bench_result *res)
+{
+    if (res->median_ns == 0) return 0;
+    return ((double)res->input_size / 1e6) / ((double)res->median_ns / 1e9);
+}
+
+void bench_print_csv_header(FILE *out)
+{
+    fprintf(out, "day,part,input_bytes,load_ns,iters,answer,min_ns,median_ns,p99_ns,max_ns,mean_ns,ns_per_byte,mb_per_s\n");
+}
+
+void bench_print(FILE *out, const struct bench_result *res, enum bench_format format)
+{
+    switch (format) {
+    case BENCH_TEXT:
+        fprintf(out, "Day %02d part %d (%zu bytes, answer %lld)\n",
+                res->day, res->part, res->input_size, res->answer);
+        fprintf(out, "  load:       %10.3f us\n", (double)res->load_ns / 1e3);
+        fprintf(out, "  iterations: %10zu\n", res->iters);
+        fprintf(out, "  min:        %10.3f us\n", (double)res->min_ns / 1e3);
+        fprintf(out, "  median:     %10.3f us\n", (double)res->median_ns / 1e3);
+        fprintf(out, "  p99:        %10.3f us\n", (double)res->p99_ns / 1e3);
+        fprintf(out, "  max:        %10.3f us\n", (double)res->max_ns / 1e3);
+        fprintf(out, "  ns/byte:    %10.3f\n", bench_ns_per_byte(res));
+        fprintf(out, "  throughput: %10.3f MB/s\n", bench_throughput(res));
+        break;
+    case BENCH_JSON:
+        fprintf(out, "{\"day\": %d, \"part\": %d, \"input_bytes\": %zu, \"load_ns\": %llu, "
+                "\"iters\": %zu, \"answer\": %lld, \"min_ns\": %llu, \"median_ns\": %llu, "
+                "\"p99_ns\": %llu, \"max_ns\": %llu, \"mean_ns\": %.1f, "
+                "\"ns_per_byte\": %.4f, \"mb_per_s\": %.3f}\n",
+                res->day, res->part, res->input_size, (unsigned long long)res->load_ns,
+                res->iters, res->answer, (unsigned long long)res->min_ns,
+                (unsigned long long)res->median_ns, (unsigned long long)res->p99_ns,
+                (unsigned long long)res->max_ns, res->mean_ns,
+                bench_ns_per_byte(res), bench_throughput(res));
+        break;
+    case BENCH_CSV:
+        fprintf(out, "%d,%d,%zu,%llu,%zu,%lld,%llu,%llu,%llu,%llu,%.1f,%.4f,%.3f\n",
+                res->day, res->part, res->input_size, (unsigned long long)res->load_ns,
+                res->iters, res->answer, (unsigned long long)res->min_ns,
+                (unsigned long long)res->median_ns, (unsigned long long)res->p99_ns,
+                (unsigned long long)res->max_ns, res->mean_ns,
+                bench_ns_per_byte(res), bench_throughput(res));
+        break;
+    }
+}
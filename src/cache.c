@@ -0,0 +1,286 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include "utils.h"
+
+// Content-addressed result cache.
+//
+// An answer is a pure function of (day, part, input), so it can be
+// stored under a hash of the input. The cache file is a header (magic
+// string and solver version) followed by fixed-size records and is only ever appended to, so
+// several processes can share it, under an flock. A torn record at the
+// end of the file (from a writer that died mid-append) is cut off when
+// the cache is opened, so later records stay aligned.
+
+#define CACHE_MAGIC "AOCCACH2"
+#define CACHE_MAGIC_PREFIX "AOCCACH" // Shared by every format version
+
+// Bump whenever a solver's answers change. A cache file written for
+// another version is emptied on open instead of serving stale answers.
+#define CACHE_SOLVER_VERSION 1
+
+struct cache_header {
+    char magic[sizeof(CACHE_MAGIC) - 1];
+    uint64_t solver_version;
+};
+
+struct cache_key {
+    uint64_t hash;
+    uint64_t size;
+    uint32_t day;
+    uint32_t part;
+};
+
+struct cache_record {
+    struct cache_key key;
+    int64_t answer;
+    uint64_t solve_ns; // how long the solver took, to report time saved
+};
+
+struct cache_entry {
+    int64_t answer;
+    uint64_t solve_ns;
+};
+
+#define RAX_HT_KEY_TYPE             struct cache_key
+#define RAX_HT_VALUE_TYPE           struct cache_entry
+#define RAX_HT_HASH(KEY)            ((KEY).hash ^ ((uint64_t)(KEY).day << 8) ^ (KEY).part)
+#define RAX_HT_KEY_EQUAL(X, Y)      ((X).hash == (Y).hash && (X).size == (Y).size \
+                                     && (X).day == (Y).day && (X).part == (Y).part)
+#define RAX_HT_NAME htcache
+#include "rax_ht.h"
+
+struct cache {
+    int fd;
+    htcache index;
+    pthread_mutex_t lock;
+
+    size_t hits;
+    size_t misses;
+    uint64_t saved_ns;
+    uint64_t hash_ns;
+};
+
+static inline uint64_t cache__rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t cache__read64(const unsigned char *p)
+{
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+static inline uint64_t cache__round(uint64_t acc, uint64_t x)
+{
+    acc += x * 0xc2b2ae3d27d4eb4fULL;
+    acc = cache__rotl(acc, 31);
+    return acc * 0x9e3779b185ebca87ULL;
+}
+
+// 64-bit hash that consumes 32 bytes per step in four independent
+// lanes (the xxHash64 structure), instead of FNV-1a's one byte.
+uint64_t cache_hash(const void *key, size_t size)
+{
+    const unsigned char *p = key;
+    const unsigned char *end = p + size;
+    const uint64_t prime1 = 0x9e3779b185ebca87ULL;
+    const uint64_t prime2 = 0xc2b2ae3d27d4eb4fULL;
+    const uint64_t prime3 = 0x165667b19e3779f9ULL;
+    const uint64_t prime4 = 0x85ebca77c2b2ae63ULL;
+    const uint64_t prime5 = 0x27d4eb2f165667c5ULL;
+
+    uint64_t h;
+    if (size >= 32) {
+        uint64_t v1 = prime1 + prime2;
+        uint64_t v2 = prime2;
+        uint64_t v3 = 0;
+        uint64_t v4 = -prime1;
+        while (end - p >= 32) {
+            v1 = cache__round(v1, cache__read64(p));
+            v2 = cache__round(v2, cache__read64(p + 8));
+            v3 = cache__round(v3, cache__read64(p + 16));
+            v4 = cache__round(v4, cache__read64(p + 24));
+            p += 32;
+        }
+
+        h = cache__rotl(v1, 1) + cache__rotl(v2, 7) + cache__rotl(v3, 12) + cache__rotl(v4, 18);
+        h = (h ^ cache__round(0, v1)) * prime1 + prime4;
+        h = (h ^ cache__round(0, v2)) * prime1 + prime4;
+        h = (h ^ cache__round(0, v3)) * prime1 + prime4;
+        h = (h ^ cache__round(0, v4)) * prime1 + prime4;
+    } else {
+        h = prime5;
+    }
+
+    h += (uint64_t)size;
+    while (end - p >= 8) {
+        h ^= cache__round(0, cache__read64(p));
+        h = cache__rotl(h, 27) * prime1 + prime4;
+        p += 8;
+    }
+
+    while (p < end) {
+        h ^= (uint64_t)*p++ * prime5;
+        h = cache__rotl(h, 11) * prime1;
+    }
+
+    h ^= h >> 33;
+    h *= prime2;
+    h ^= h >> 29;
+    h *= prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+// Open (or create) the cache file at path and load its index.
+// Return false if the file cannot be used.
+bool cache_open(struct cache *cache, const char *path)
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->fd = -1;
+    pthread_mutex_init(&cache->lock, NULL);
+
+    cache->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (cache->fd < 0) {
+        perror("Failed to open cache file");
+        return false;
+    }
+
+    // Exclusive while checking the header and trimming the tail, so no
+    // other process appends in between
+    if (flock(cache->fd, LOCK_EX) < 0) {
+        perror("Failed to lock cache file");
+        close(cache->fd);
+        return false;
+    }
+
+    struct cache_header header = { .solver_version = CACHE_SOLVER_VERSION };
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+
+    struct cache_header found;
+    ssize_t n = read(cache->fd, &found, sizeof(found));
+    bool is_cache = n >= (ssize_t)sizeof(CACHE_MAGIC_PREFIX) - 1
+                 && memcmp(found.magic, CACHE_MAGIC_PREFIX, sizeof(CACHE_MAGIC_PREFIX) - 1) == 0;
+    bool current = n == (ssize_t)sizeof(found) && memcmp(&found, &header, sizeof(header)) == 0;
+    if (n != 0 && !is_cache) {
+        fprintf(stderr, "%s is not a cache file\n", path);
+        flock(cache->fd, LOCK_UN);
+        close(cache->fd);
+        return false;
+    }
+
+    if (!current) {
+        if (n != 0)
+            fprintf(stderr, "%s was written by another format or solver version, emptying it\n", path);
+
+        bool ok = ftruncate(cache->fd, 0) == 0
+               && write(cache->fd, &header, sizeof(header)) == (ssize_t)sizeof(header);
+        if (!ok) perror("Failed to write cache file");
+        flock(cache->fd, LOCK_UN);
+        if (!ok) close(cache->fd);
+        return ok;
+    }
+
+    off_t end = (off_t)sizeof(header);
+    struct cache_record rec;
+    while (read(cache->fd, &rec, sizeof(rec)) == (ssize_t)sizeof(rec)) {
+        struct cache_entry entry = {
+            .answer = rec.answer,
+            .solve_ns = rec.solve_ns,
+        };
+        htcache_set(&cache->index, rec.key, entry);
+        end += (off_t)sizeof(rec);
+    }
+
+    struct stat st;
+    if (fstat(cache->fd, &st) == 0 && st.st_size > end && ftruncate(cache->fd, end) < 0)
+        perror("Failed to trim cache file");
+
+    flock(cache->fd, LOCK_UN);
+    return true;
+}
+
+void cache_close(struct cache *cache)
+{
+    if (cache->fd >= 0)
+        close(cache->fd);
+    htcache_destroy(&cache->index);
+    pthread_mutex_destroy(&cache->lock);
+}
+
+// Return the answer for f on input, from the cache if possible.
+// Misses are solved and appended to the cache file.
+long long cache_solve(struct cache *cache, int day, int part,
+                      long long (*f)(const char *), const char *input)
+{
+    uint64_t start = now_ns();
+    size_t size = strlen(input);
+    struct cache_key key = {
+        .hash = cache_hash(input, size),
+        .size = size,
+        .day = (uint32_t)day,
+        .part = (uint32_t)part,
+    };
+    uint64_t hash_ns = now_ns() - start;
+
+    pthread_mutex_lock(&cache->lock);
+    cache->hash_ns += hash_ns;
+    struct cache_entry *hit = htcache_get(&cache->index, key);
+    if (hit) {
+        long long answer = hit->answer;
+        cache->hits++;
+        cache->saved_ns += hit->solve_ns;
+        pthread_mutex_unlock(&cache->lock);
+        return answer;
+    }
+    cache->misses++;
+    pthread_mutex_unlock(&cache->lock);
+
+    start = now_ns();
+    long long answer = f(input);
+
+    // -1 is how solvers report bad input or allocation failure
+    if (answer == -1)
+        return answer;
+
+    struct cache_record rec = {
+        .key = key,
+        .answer = answer,
+        .solve_ns = now_ns() - start,
+    };
+
+    pthread_mutex_lock(&cache->lock);
+    struct cache_entry entry = {
+        .answer = rec.answer,
+        .solve_ns = rec.solve_ns,
+    };
+    htcache_set(&cache->index, key, entry);
+
+    // O_APPEND with a single write keeps records whole when several
+    // processes share the file. The lock keeps it clear of another
+    // process trimming the tail.
+    flock(cache->fd, LOCK_EX);
+    if (write(cache->fd, &rec, sizeof(rec)) != (ssize_t)sizeof(rec))
+        perror("Failed to append to cache file");
+    flock(cache->fd, LOCK_UN);
+    pthread_mutex_unlock(&cache->lock);
+
+    return answer;
+}
+
+void cache_print_stats(FILE *out, const struct cache *cache)
+{
+    fprintf(out, "Cache: %zu hits, %zu misses, saved %.3f ms (hashing took %.3f ms)\n",
+            cache->hits, cache->misses,
+            (double)cache->saved_ns / 1e6, (double)cache->hash_ns / 1e6);
+}
@@ -1,41 +1,487 @@
+#include <limits.h>
 #include <stddef.h>
 #include <string.h>
 #include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "pool.h"
 
-int day01_move_to_floor(const char *input)
+#if defined(__x86_64__) || defined(__i386__)
+#define DAY01_X86
+#include <immintrin.h>
+#endif
+
+// Counting kernels. Each one walks s[0, size) until the first byte that
+// is neither '(' nor ')', and returns its index (size if there is
+// none). *floor gets the number of '(' minus the number of ')' before
+// that index.
+
+size_t day01_count_scalar(const char *s, size_t size, long long *floor)
 {
-    ptrdiff_t size = (ptrdiff_t)strlen(input);
-    int count = 0;
-    for (int i = 0; i < size; i++) {
-        if (input[i] == '(') {
+    long long count = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (s[i] == '(') {
             count++;
-        } else if (input[i] == ')') {
+        } else if (s[i] == ')') {
             count--;
         } else {
-            fprintf(stderr, "Invalid character at position %d: %c\n", i, input[i]);
-            return -1;
+            *floor = count;
+            return i;
         }
     }
 
-    return count;
+    *floor = count;
+    return size;
 }
 
-int day01_basement_position(const char *input)
+#ifdef DAY01_X86
+
+// '(' is 0x28 and ')' is 0x29, so a byte is valid iff (byte | 1) == ')',
+// and (byte & 1) is 1 for ')' and 0 for '('. The low bits of a block
+// are summed with psadbw; a block with any invalid byte is left to the
+// scalar kernel, which finds the exact position.
+
+__attribute__((target("sse2")))
+size_t day01_count_sse2(const char *s, size_t size, long long *floor)
 {
-    ptrdiff_t size = (ptrdiff_t)strlen(input);
-    int floor = 0;
-    int pos = 0;
-    for (pos = 0; pos < size; pos++) {
-        if (input[pos] == '(')
-            floor++;
-        else if (input[pos] == ')')
-            floor--;
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i close = _mm_set1_epi8(')');
+    __m128i closes = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(s + i + 16));
+        __m128i v2 = _mm_loadu_si128((const __m128i *)(s + i + 32));
+        __m128i v3 = _mm_loadu_si128((const __m128i *)(s + i + 48));
 
-        if (floor < 0)
+        __m128i ok = _mm_and_si128(
+            _mm_and_si128(_mm_cmpeq_epi8(_mm_or_si128(v0, one), close),
+                          _mm_cmpeq_epi8(_mm_or_si128(v1, one), close)),
+            _mm_and_si128(_mm_cmpeq_epi8(_mm_or_si128(v2, one), close),
+                          _mm_cmpeq_epi8(_mm_or_si128(v3, one), close)));
+        if (_mm_movemask_epi8(ok) != 0xffff)
+            break;
+
+        __m128i bits = _mm_add_epi8(
+            _mm_add_epi8(_mm_and_si128(v0, one), _mm_and_si128(v1, one)),
+            _mm_add_epi8(_mm_and_si128(v2, one), _mm_and_si128(v3, one)));
+        closes = _mm_add_epi64(closes, _mm_sad_epu8(bits, _mm_setzero_si128()));
+    }
+
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, closes);
+    long long n_closes = (long long)(lanes[0] + lanes[1]);
+
+    long long rest;
+    size_t bad = day01_count_scalar(s + i, size - i, &rest);
+    *floor = (long long)i - 2 * n_closes + rest;
+    return i + bad;
+}
+
+__attribute__((target("avx2")))
+size_t day01_count_avx2(const char *s, size_t size, long long *floor)
+{
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i close = _mm256_set1_epi8(')');
+    __m256i closes = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for (; i + 128 <= size; i += 128) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(s + i + 32));
+        __m256i v2 = _mm256_loadu_si256((const __m256i *)(s + i + 64));
+        __m256i v3 = _mm256_loadu_si256((const __m256i *)(s + i + 96));
+
+        __m256i ok = _mm256_and_si256(
+            _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_or_si256(v0, one), close),
+                             _mm256_cmpeq_epi8(_mm256_or_si256(v1, one), close)),
+            _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_or_si256(v2, one), close),
+                             _mm256_cmpeq_epi8(_mm256_or_si256(v3, one), close)));
+        if ((uint32_t)_mm256_movemask_epi8(ok) != 0xffffffff)
+            break;
+
+        __m256i bits = _mm256_add_epi8(
+            _mm256_add_epi8(_mm256_and_si256(v0, one), _mm256_and_si256(v1, one)),
+            _mm256_add_epi8(_mm256_and_si256(v2, one), _mm256_and_si256(v3, one)));
+        closes = _mm256_add_epi64(closes, _mm256_sad_epu8(bits, _mm256_setzero_si256()));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, closes);
+    long long n_closes = (long long)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+
+    long long rest;
+    size_t bad = day01_count_sse2(s + i, size - i, &rest);
+    *floor = (long long)i - 2 * n_closes + rest;
+    return i + bad;
+}
+
+bool day01_sse2_supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+}
+
+bool day01_avx2_supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif // DAY01_X86
+
+bool day01_always_supported(void)
+{
+    return true;
+}
+
+struct day01_kernel {
+    const char *name;
+    size_t (*count)(const char *s, size_t size, long long *floor);
+    bool (*supported)(void);
+};
+
+// Widest first
+const struct day01_kernel day01_kernels[] = {
+#ifdef DAY01_X86
+    {"avx2", day01_count_avx2, day01_avx2_supported},
+    {"sse2", day01_count_sse2, day01_sse2_supported},
+#endif
+    {"scalar", day01_count_scalar, day01_always_supported},
+};
+
+const struct day01_kernel *day01_best_kernel(void)
+{
+    for (size_t i = 0; i < SIZE(day01_kernels); i++)
+        if (day01_kernels[i].supported())
+            return &day01_kernels[i];
+
+    return &day01_kernels[SIZE(day01_kernels) - 1];
+}
+
+long long day01_move_to_floor(const char *input)
+{
+    PROF_ZONE("day01/solve");
+    size_t size = strlen(input);
+    long long floor;
+    size_t bad = day01_best_kernel()->count(input, size, &floor);
+    if (bad < size) {
+        fprintf(stderr, "Invalid character at position %zu: %c\n", bad, input[bad]);
+        return -1;
+    }
+
+    return floor;
+}
+
+// Walk s[0, size) starting at *floor. Return the 1-based position at
+// which the floor first drops below zero, or 0 if it never does, and
+// leave the floor at that point in *floor. Bytes other than parens
+// don't move the floor.
+size_t day01_scan_basement(const char *s, size_t size, long long *floor)
+{
+    long long f = *floor;
+    for (size_t pos = 0; pos < size; pos++) {
+        if (s[pos] == '(')
+            f++;
+        else if (s[pos] == ')')
+            f--;
+
+        if (f < 0) {
+            *floor = f;
             return pos + 1;
+        }
+    }
+
+    *floor = f;
+    return 0;
+}
+
+// Parallel part 2. Each chunk of the input is summarized by its net
+// change in floor and the lowest floor reached inside it, relative to
+// its start. Scanning the summaries in order finds the first chunk in
+// which the floor can drop below zero, and only that chunk is walked
+// byte by byte.
+
+struct day01_summary {
+    long long delta;
+    long long min; // LLONG_MAX for an empty chunk
+};
+
+void day01_summarize_scalar(const char *s, size_t size, struct day01_summary *sum)
+{
+    long long floor = 0;
+    long long min = LLONG_MAX;
+    for (size_t i = 0; i < size; i++) {
+        floor += (s[i] == '(') - (s[i] == ')');
+        if (floor < min) min = floor;
+    }
+
+    sum->delta = floor;
+    sum->min = min;
+}
+
+#ifdef DAY01_X86
+
+// In-register prefix sums of +1/-1/0 bytes. Over 16 bytes they stay
+// within int8. The horizontal min is skipped whenever the block can't
+// reach below the minimum so far, which is most of the time once the
+// floor has moved away from it.
+
+__attribute__((target("sse2")))
+void day01_summarize_sse2(const char *s, size_t size, struct day01_summary *sum)
+{
+    const __m128i open = _mm_set1_epi8('(');
+    const __m128i close = _mm_set1_epi8(')');
+    const __m128i bias = _mm_set1_epi8((char)0x80);
+
+    long long floor = 0;
+    long long min = LLONG_MAX;
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i p = _mm_sub_epi8(_mm_cmpeq_epi8(v, close), _mm_cmpeq_epi8(v, open));
+        p = _mm_add_epi8(p, _mm_slli_si128(p, 1));
+        p = _mm_add_epi8(p, _mm_slli_si128(p, 2));
+        p = _mm_add_epi8(p, _mm_slli_si128(p, 4));
+        p = _mm_add_epi8(p, _mm_slli_si128(p, 8));
+
+        if (floor - 16 < min) {
+            // Signed min through an unsigned min on biased bytes
+            __m128i m = _mm_xor_si128(p, bias);
+            m = _mm_min_epu8(m, _mm_srli_si128(m, 8));
+            m = _mm_min_epu8(m, _mm_srli_si128(m, 4));
+            m = _mm_min_epu8(m, _mm_srli_si128(m, 2));
+            m = _mm_min_epu8(m, _mm_srli_si128(m, 1));
+            long long block_min = (long long)(_mm_cvtsi128_si32(m) & 0xff) - 128;
+            if (floor + block_min < min) min = floor + block_min;
+        }
+
+        floor += (int8_t)(_mm_extract_epi16(p, 7) >> 8);
     }
 
-    return -1;
+    struct day01_summary tail;
+    day01_summarize_scalar(s + i, size - i, &tail);
+    if (tail.min != LLONG_MAX && floor + tail.min < min)
+        min = floor + tail.min;
+
+    sum->delta = floor + tail.delta;
+    sum->min = min;
+}
+
+// Same as SSE2, on two independent 16 byte halves per register
+__attribute__((target("avx2")))
+void day01_summarize_avx2(const char *s, size_t size, struct day01_summary *sum)
+{
+    const __m256i open = _mm256_set1_epi8('(');
+    const __m256i close = _mm256_set1_epi8(')');
+    const __m256i bias = _mm256_set1_epi8((char)0x80);
+
+    long long floor = 0;
+    long long min = LLONG_MAX;
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i p = _mm256_sub_epi8(_mm256_cmpeq_epi8(v, close), _mm256_cmpeq_epi8(v, open));
+        p = _mm256_add_epi8(p, _mm256_slli_si256(p, 1));
+        p = _mm256_add_epi8(p, _mm256_slli_si256(p, 2));
+        p = _mm256_add_epi8(p, _mm256_slli_si256(p, 4));
+        p = _mm256_add_epi8(p, _mm256_slli_si256(p, 8));
+
+        long long lo_total = (int8_t)_mm256_extract_epi8(p, 15);
+        long long hi_total = (int8_t)_mm256_extract_epi8(p, 31);
+
+        if (floor - 32 < min) {
+            __m256i m = _mm256_xor_si256(p, bias);
+            m = _mm256_min_epu8(m, _mm256_srli_si256(m, 8));
+            m = _mm256_min_epu8(m, _mm256_srli_si256(m, 4));
+            m = _mm256_min_epu8(m, _mm256_srli_si256(m, 2));
+            m = _mm256_min_epu8(m, _mm256_srli_si256(m, 1));
+            long long lo_min = (long long)(_mm_cvtsi128_si32(_mm256_castsi256_si128(m)) & 0xff) - 128;
+            long long hi_min = (long long)(_mm_cvtsi128_si32(_mm256_extracti128_si256(m, 1)) & 0xff) - 128;
+            if (floor + lo_min < min) min = floor + lo_min;
+            if (floor + lo_total + hi_min < min) min = floor + lo_total + hi_min;
+        }
+
+        floor += lo_total + hi_total;
+    }
+
+    struct day01_summary tail;
+    day01_summarize_sse2(s + i, size - i, &tail);
+    if (tail.min != LLONG_MAX && floor + tail.min < min)
+        min = floor + tail.min;
+
+    sum->delta = floor + tail.delta;
+    sum->min = min;
+}
+
+#endif // DAY01_X86
+
+void (*day01_best_summarize(void))(const char *, size_t, struct day01_summary *)
+{
+#ifdef DAY01_X86
+    if (day01_avx2_supported()) return day01_summarize_avx2;
+    if (day01_sse2_supported()) return day01_summarize_sse2;
+#endif
+    return day01_summarize_scalar;
+}
+
+struct day01_chunk {
+    const char *s;
+    size_t offset; // Of s in the whole input
+    size_t size;
+    void (*summarize)(const char *, size_t, struct day01_summary *);
+    struct day01_summary summary;
+};
+
+void day01_chunk_run(void *arg)
+{
+    struct day01_chunk *chunk = arg;
+    chunk->summarize(chunk->s, chunk->size, &chunk->summary);
+}
+
+// Exclusive scan over the summaries of a window of n chunks, carrying
+// *floor across. Return the 1-based position in the whole input at which
+// the floor first drops below zero, or 0 if it doesn't in this window.
+size_t day01_scan_window(const struct day01_chunk *chunks, size_t n, long long *floor)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (chunks[i].summary.min != LLONG_MAX && *floor + chunks[i].summary.min < 0) {
+            size_t found = day01_scan_basement(chunks[i].s, chunks[i].size, floor);
+            assert(found > 0);
+            return chunks[i].offset + found;
+        }
+        *floor += chunks[i].summary.delta;
+    }
+
+    return 0;
+}
+
+// Chunks are summarized a window of n_threads at a time, so an early
+// answer doesn't pay for summarizing the whole input.
+// Return the same as day01_scan_basement from a floor of 0.
+size_t day01_basement_parallel(const char *s, size_t size, size_t n_threads, size_t chunk_size)
+{
+    struct day01_chunk *chunks = calloc(n_threads, sizeof(*chunks));
+    assert(chunks);
+
+    struct pool pool;
+    bool have_pool = n_threads > 1 && pool_init(&pool, n_threads, 0);
+    void (*summarize)(const char *, size_t, struct day01_summary *) = day01_best_summarize();
+
+    long long floor = 0;
+    size_t pos = 0;
+    size_t answer = 0;
+    while (pos < size && answer == 0) {
+        size_t n = 0;
+        for (; n < n_threads && pos < size; n++) {
+            size_t len = size - pos < chunk_size ? size - pos : chunk_size;
+            chunks[n] = (struct day01_chunk) {
+                .s = s + pos,
+                .offset = pos,
+                .size = len,
+                .summarize = summarize,
+            };
+            pos += len;
+        }
+
+        if (have_pool) {
+            for (size_t i = 0; i < n; i++)
+                pool_submit(&pool, day01_chunk_run, &chunks[i]);
+            pool_wait(&pool);
+        } else {
+            for (size_t i = 0; i < n; i++)
+                day01_chunk_run(&chunks[i]);
+        }
+
+        answer = day01_scan_window(chunks, n, &floor);
+    }
+
+    if (have_pool) pool_destroy(&pool);
+    free(chunks);
+    return answer;
+}
+
+// Inputs below this are walked on one thread
+#ifndef DAY01_PARALLEL_MIN
+#define DAY01_PARALLEL_MIN (4 * 1024 * 1024)
+#endif
+#define DAY01_CHUNK_SIZE (1024 * 1024)
+
+long long day01_basement_position(const char *input)
+{
+    PROF_ZONE("day01/solve");
+    size_t size = strlen(input);
+
+    size_t pos;
+    if (size < DAY01_PARALLEL_MIN) {
+        long long floor = 0;
+        pos = day01_scan_basement(input, size, &floor);
+    } else {
+        pos = day01_basement_parallel(input, size, pool_default_threads(), DAY01_CHUNK_SIZE);
+    }
+
+    // Positions are 1-based, so -1 can't collide with one
+    return pos > 0 ? (long long)pos : -1;
+}
+
+// Streaming versions. The state only holds the current floor, so the
+// input can be arbitrarily large.
+struct day01_stream {
+    int part;
+    long long floor;
+    size_t pos;
+    long long answer;
+    bool done;
+};
+
+void *day01_stream_init_part(int part)
+{
+    struct day01_stream *st = calloc(1, sizeof(*st));
+    if (st) st->part = part;
+    return st;
+}
+
+void *day01_stream_init(void)
+{
+    return day01_stream_init_part(1);
+}
+
+void *day01_stream_init_2(void)
+{
+    return day01_stream_init_part(2);
+}
+
+enum stream_status day01_stream_feed(void *state, const char *chunk, size_t size)
+{
+    struct day01_stream *st = state;
+    for (size_t i = 0; i < size && !st->done; i++, st->pos++) {
+        if (chunk[i] == '(') {
+            st->floor++;
+        } else if (chunk[i] == ')') {
+            st->floor--;
+        } else if (st->part == 1) {
+            fprintf(stderr, "Invalid character at position %zu: %c\n", st->pos, chunk[i]);
+            st->answer = -1;
+            st->done = true;
+        }
+
+        if (st->part == 2 && st->floor < 0) {
+            st->answer = (long long)st->pos + 1;
+            st->done = true;
+        }
+    }
+
+    return st->done ? STREAM_DONE : STREAM_MORE;
+}
+
+long long day01_stream_finish(void *state)
+{
+    struct day01_stream *st = state;
+    long long answer = st->done ? st->answer : (st->part == 1 ? st->floor : -1);
+    free(st);
+    return answer;
 }
 
 void day01_tests()
@@ -47,6 +493,84 @@ void day01_tests()
     assert(day01_move_to_floor("(()(()(") == 3);
     assert(day01_move_to_floor("))(") == -1);
 
+    // Every kernel must agree with the scalar one, whatever the length
+    // and wherever the first invalid byte is
+    char buf[1024];
+    for (size_t i = 0; i < sizeof(buf); i++)
+        buf[i] = (i * 7 + i / 3) % 5 < 2 ? ')' : '(';
+
+    for (size_t k = 0; k < SIZE(day01_kernels); k++) {
+        const struct day01_kernel *kernel = &day01_kernels[k];
+        if (!kernel->supported()) continue;
+
+        for (size_t size = 0; size <= sizeof(buf); size += 61) {
+            for (size_t bad = 0; bad <= size; bad += 37) {
+                char saved = bad < size ? buf[bad] : 0;
+                if (bad < size) buf[bad] = '\n';
+
+                long long expected_floor, floor;
+                size_t expected = day01_count_scalar(buf, size, &expected_floor);
+                assert(kernel->count(buf, size, &floor) == expected);
+                assert(floor == expected_floor);
+
+                if (bad < size) buf[bad] = saved;
+            }
+        }
+    }
+
+    // Summaries must match the scalar ones, and the parallel search the
+    // sequential one, for any split of the input
+    char walk[20000 + 1];
+    uint64_t x = 2015;
+    for (size_t i = 0; i < sizeof(walk) - 1; i++) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        unsigned v = (unsigned)(x >> 56);
+        walk[i] = i < 10 ? '(' : v < 16 ? 'x' : v < 16 + 118 ? '(' : ')';
+    }
+    walk[sizeof(walk) - 1] = '\0';
+
+    for (size_t size = 0; size < 300; size += 7) {
+        struct day01_summary expected, sum;
+        day01_summarize_scalar(walk + 3, size, &expected);
+        day01_best_summarize()(walk + 3, size, &sum);
+        assert(sum.delta == expected.delta && sum.min == expected.min);
+    }
+
+    long long floor = 0;
+    size_t expected = day01_scan_basement(walk, sizeof(walk) - 1, &floor);
+    assert(expected > 1000);
+    size_t chunk_sizes[] = {1, 7, 64, 1000, 100000};
+    for (size_t n_threads = 1; n_threads <= 3; n_threads++) {
+        for (size_t i = 0; i < SIZE(chunk_sizes); i++) {
+            assert(day01_basement_parallel(walk, sizeof(walk) - 1, n_threads, chunk_sizes[i]) == expected);
+            assert(day01_basement_parallel("(()(", 4, n_threads, chunk_sizes[i]) == 0);
+        }
+    }
+
+    // A window whose answer lies past INT_MAX, without the 2GB input:
+    // a balanced first chunk, then a ")"
+    struct day01_chunk window[2] = {
+        {.offset = 0, .size = (size_t)INT_MAX + 10, .summary = {.delta = 0, .min = 0}},
+        {.s = ")", .offset = (size_t)INT_MAX + 10, .size = 1},
+    };
+    day01_summarize_scalar(window[1].s, window[1].size, &window[1].summary);
+    floor = 0;
+    assert(day01_scan_window(window, 2, &floor) == (size_t)INT_MAX + 11);
+
+    // Stream answers past INT_MAX, from a state that has already seen
+    // the first 2GB
+    struct day01_stream *st = day01_stream_init();
+    assert(st);
+    st->floor = INT_MAX;
+    assert(day01_stream_feed(st, "((", 2) == STREAM_MORE);
+    assert(day01_stream_finish(st) == (long long)INT_MAX + 2);
+
+    st = day01_stream_init_2();
+    assert(st);
+    st->pos = (size_t)INT_MAX + 5;
+    assert(day01_stream_feed(st, ")", 1) == STREAM_DONE);
+    assert(day01_stream_finish(st) == (long long)INT_MAX + 6);
+
     assert(day01_basement_position(")") == 1);
     assert(day01_basement_position("()())") == 5);
 }
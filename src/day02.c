@@ -1,82 +1,314 @@
+#include <stdint.h>
 #include "utils.h"
 
 #define RAX_STRV_IMPLEMENTATION
 #include "rax_strv.h"
 
-void day02_parse_dims(strv view, int *dims)
+#if defined(__x86_64__) || defined(__i386__)
+#define DAY02_X86
+#include <immintrin.h>
+#endif
+
+// SWAR digit parsing: up to 8 bytes of the line are loaded into one
+// word, first character in the low byte.
+
+#define DAY02_ONES  0x0101010101010101ULL
+#define DAY02_HIGHS 0x8080808080808080ULL
+
+// Parse the run of 1 to 8 digits at the start of view, advancing past
+// it. A ninth digit is left for the caller to reject as a separator.
+bool day02_parse_number(strv *view, int *n)
 {
-    // Get a string to use strtol.
-    char line[512];
-    snprintf(line, sizeof(line), strv_fmt, strv_arg(view));
+    uint64_t word = 0;
+    if (view->size >= 8)
+        memcpy(&word, view->str, 8);
+    else
+        memcpy(&word, view->str, view->size);
+
+    // Digits become 0-9, anything else (including the zero padding)
+    // becomes a byte of 10 or more, which sets its high bit below.
+    uint64_t x = word ^ (0x30 * DAY02_ONES);
+    uint64_t non_digits = (((x & ~DAY02_HIGHS) + 0x76 * DAY02_ONES) | x) & DAY02_HIGHS;
+
+    size_t len = non_digits ? (size_t)__builtin_ctzll(non_digits) / 8 : 8;
+    if (len == 0) return false;
 
-    char *end = (char *)line;
-    for (size_t i = 0; i < 3; i++, end++)
-        dims[i] = strtol(end, &end, 10);
+    // Push the digits to the top of the word (leading zeros don't
+    // change the value), then combine them pairwise.
+    x <<= 8 * (8 - len);
+    x = ((x & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+    x = ((x & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+    x = ((x & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+
+    *n = (int)x;
+    view->str += len;
+    view->size -= len;
+    return true;
 }
 
-int day02_single_total(strv view)
+// Largest dimension whose box math fits a long long: a cube this size
+// has a volume of 8e18, just under 2^63.
+#define DAY02_MAX_DIM 2000000
+
+// Parse one "LxWxH" line at the start of view and advance past it and
+// its newline. Nothing else is allowed on the line.
+bool day02_parse_box(strv *view, int *dims)
 {
-    int dims[3];
-    day02_parse_dims(view, dims);
+    for (size_t i = 0; i < 3; i++) {
+        if (!day02_parse_number(view, &dims[i]) || dims[i] > DAY02_MAX_DIM)
+            return false;
 
-    int faces[3] = {
-        dims[0] * dims[1],
-        dims[1] * dims[2],
-        dims[2] * dims[0],
-    };
+        char sep = i < 2 ? 'x' : '\n';
+        if (view->size > 0) {
+            if (view->str[0] != sep) return false;
+            view->str++;
+            view->size--;
+        } else if (i < 2) {
+            return false;
+        }
+    }
 
-    int smallest = faces[0];
-    for (size_t i = 1; i < SIZE(faces); i++)
-        if (faces[i] < smallest) smallest = faces[i];
+    return true;
+}
 
-    int tot = smallest;
-    for (size_t i = 0; i < SIZE(faces); i++)
-        tot += 2 * faces[i];
+struct day02_totals {
+    long long paper;
+    long long ribbon;
+    // Set once a total goes past LLONG_MAX
+    bool paper_overflow;
+    bool ribbon_overflow;
+};
 
-    return tot;
+void day02_totals_add(struct day02_totals *totals, long long paper, long long ribbon)
+{
+    totals->paper_overflow |= __builtin_add_overflow(totals->paper, paper, &totals->paper);
+    totals->ribbon_overflow |= __builtin_add_overflow(totals->ribbon, ribbon, &totals->ribbon);
 }
 
-int day02_single_ribbon(strv view)
+// Boxes are parsed into a batch of separate L, W and H arrays, and the
+// box math runs over the whole batch at once.
+
+#define DAY02_BATCH 2048
+
+struct day02_batch {
+    size_t size;
+    uint32_t dims_or; // Every dimension OR'd together, to bound them
+    uint32_t l[DAY02_BATCH];
+    uint32_t w[DAY02_BATCH];
+    uint32_t h[DAY02_BATCH];
+};
+
+// Paper is the three faces twice plus the smallest face, ribbon the
+// smallest perimeter plus the volume. The smallest face and perimeter
+// both come from the two smallest dimensions. A single box always fits,
+// but a few large ones can overflow the sums.
+void day02_totals_scalar(const struct day02_batch *b, size_t start, size_t end,
+                         struct day02_totals *totals)
 {
-    int dims[3];
-    day02_parse_dims(view, dims);
+    long long paper = 0;
+    long long ribbon = 0;
+    bool paper_overflow = false, ribbon_overflow = false;
+    for (size_t i = start; i < end; i++) {
+        long long l = b->l[i], w = b->w[i], h = b->h[i];
+        long long lo = l < w ? l : w;
+        long long hi = l < w ? w : l;
+        long long mid = h < hi ? h : hi;
+        if (h < lo) mid = lo, lo = h;
 
-    int perims[] = {
-        2 * (dims[0] + dims[1]),
-        2 * (dims[0] + dims[2]),
-        2 * (dims[1] + dims[2]),
-    };
+        paper_overflow |= __builtin_add_overflow(paper, 2 * (l * w + w * h + h * l) + lo * mid, &paper);
+        ribbon_overflow |= __builtin_add_overflow(ribbon, 2 * (lo + mid) + l * w * h, &ribbon);
+    }
+
+    totals->paper_overflow |= paper_overflow;
+    totals->ribbon_overflow |= ribbon_overflow;
+    day02_totals_add(totals, paper, ribbon);
+}
 
-    int smallest = perims[0];
-    for (size_t i = 1; i < SIZE(perims); i++)
-        if (perims[i] < smallest) smallest = perims[i];
+#ifdef DAY02_X86
 
-    int vol = dims[0] * dims[1] * dims[2];
-    return smallest + vol;
+// Below this every per-box value fits in 32 bits
+#define DAY02_AVX2_MAX_DIM 1024
+
+// 8 boxes per step in 32-bit lanes, widened to 64 bits to accumulate.
+// Return the number of boxes done, a multiple of 8.
+__attribute__((target("avx2")))
+size_t day02_totals_avx2(const struct day02_batch *b, struct day02_totals *totals)
+{
+    __m256i paper = _mm256_setzero_si256();
+    __m256i ribbon = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for (; i + 8 <= b->size; i += 8) {
+        __m256i l = _mm256_loadu_si256((const __m256i *)(b->l + i));
+        __m256i w = _mm256_loadu_si256((const __m256i *)(b->w + i));
+        __m256i h = _mm256_loadu_si256((const __m256i *)(b->h + i));
+
+        __m256i lw = _mm256_mullo_epi32(l, w);
+        __m256i wh = _mm256_mullo_epi32(w, h);
+        __m256i hl = _mm256_mullo_epi32(h, l);
+
+        __m256i lo = _mm256_min_epu32(_mm256_min_epu32(l, w), h);
+        __m256i hi = _mm256_max_epu32(_mm256_max_epu32(l, w), h);
+        __m256i sum = _mm256_add_epi32(_mm256_add_epi32(l, w), h);
+        __m256i mid = _mm256_sub_epi32(_mm256_sub_epi32(sum, lo), hi);
+
+        __m256i faces = _mm256_add_epi32(_mm256_add_epi32(lw, wh), hl);
+        __m256i p = _mm256_add_epi32(_mm256_add_epi32(faces, faces), _mm256_mullo_epi32(lo, mid));
+        __m256i perim = _mm256_add_epi32(lo, mid);
+        __m256i r = _mm256_add_epi32(_mm256_add_epi32(perim, perim), _mm256_mullo_epi32(lw, h));
+
+        paper = _mm256_add_epi64(paper, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(p)));
+        paper = _mm256_add_epi64(paper, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(p, 1)));
+        ribbon = _mm256_add_epi64(ribbon, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(r)));
+        ribbon = _mm256_add_epi64(ribbon, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(r, 1)));
+    }
+
+    // A batch of small boxes can't overflow, only the running totals
+    long long paper_lanes[4], ribbon_lanes[4];
+    _mm256_storeu_si256((__m256i *)paper_lanes, paper);
+    _mm256_storeu_si256((__m256i *)ribbon_lanes, ribbon);
+    day02_totals_add(totals, paper_lanes[0] + paper_lanes[1] + paper_lanes[2] + paper_lanes[3],
+                     ribbon_lanes[0] + ribbon_lanes[1] + ribbon_lanes[2] + ribbon_lanes[3]);
+    return i;
 }
 
-int day02_wrapping_paper(const char *input)
+bool day02_avx2_supported(void)
 {
-    strv_it it = {0};
-    strv_lines(&it, input);
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
 
-    int tot = 0;
-    while (strv_next(&it))
-        tot += day02_single_total(it.sv);
+#endif // DAY02_X86
 
-    return tot;
+// Add the boxes in b to totals and empty it
+void day02_batch_flush(struct day02_batch *b, struct day02_totals *totals)
+{
+    size_t done = 0;
+#ifdef DAY02_X86
+    if (b->dims_or < DAY02_AVX2_MAX_DIM && day02_avx2_supported())
+        done = day02_totals_avx2(b, totals);
+#endif
+    day02_totals_scalar(b, done, b->size, totals);
+
+    b->size = 0;
+    b->dims_or = 0;
+}
+
+void day02_batch_push(struct day02_batch *b, const int *dims, struct day02_totals *totals)
+{
+    b->l[b->size] = (uint32_t)dims[0];
+    b->w[b->size] = (uint32_t)dims[1];
+    b->h[b->size] = (uint32_t)dims[2];
+    b->dims_or |= b->l[b->size] | b->w[b->size] | b->h[b->size];
+    if (++b->size == DAY02_BATCH)
+        day02_batch_flush(b, totals);
 }
 
-int day02_ribbon(const char *input)
+// Both parts come out of one pass over the input, since parsing is
+// where the time goes. Return false on a malformed line. A total that
+// overflows is only flagged, since the other part may still be fine.
+bool day02_solve(const char *input, struct day02_totals *totals)
 {
-    strv_it it = {0};
-    strv_lines(&it, input);
+    *totals = (struct day02_totals) {0};
+    struct day02_batch batch;
+    batch.size = 0;
+    batch.dims_or = 0;
+
+    strv view = strv_from(input);
+    while (view.size > 0) {
+        // Blank lines, usually just the one at the end, hold no box
+        if (view.str[0] == '\n') {
+            view = strv_chop_left(view, 1);
+            continue;
+        }
 
-    int tot = 0;
-    while (strv_next(&it))
-        tot += day02_single_ribbon(it.sv);
+        strv line = view;
+        int dims[3];
+        if (!day02_parse_box(&view, dims)) {
+            const char *nl = memchr(line.str, '\n', line.size);
+            size_t len = nl ? (size_t)(nl - line.str) : line.size;
+            fprintf(stderr, "Invalid box: \"%.*s\"\n", (int)len, line.str);
+            return false;
+        }
 
-    return tot;
+        day02_batch_push(&batch, dims, totals);
+    }
+
+    day02_batch_flush(&batch, totals);
+    return true;
+}
+
+long long day02_wrapping_paper(const char *input)
+{
+    PROF_ZONE("day02/solve");
+    struct day02_totals totals;
+    return day02_solve(input, &totals) && !totals.paper_overflow ? totals.paper : -1;
+}
+
+long long day02_ribbon(const char *input)
+{
+    PROF_ZONE("day02/solve");
+    struct day02_totals totals;
+    return day02_solve(input, &totals) && !totals.ribbon_overflow ? totals.ribbon : -1;
+}
+
+struct day02_stream {
+    int part;
+    bool invalid;
+    struct day02_totals totals;
+    struct day02_batch batch;
+    struct line_splitter lines;
+};
+
+void *day02_stream_init_part(int part)
+{
+    struct day02_stream *st = calloc(1, sizeof(*st));
+    if (st) st->part = part;
+    return st;
+}
+
+void *day02_stream_init(void)
+{
+    return day02_stream_init_part(1);
+}
+
+void *day02_stream_init_2(void)
+{
+    return day02_stream_init_part(2);
+}
+
+void day02_stream_line(void *ctx, const char *line, size_t size)
+{
+    struct day02_stream *st = ctx;
+    strv view = strv_from_range(line, 0, size);
+    if (st->invalid || size == 0) return;
+
+    int dims[3];
+    if (!day02_parse_box(&view, dims) || view.size > 0) {
+        fprintf(stderr, "Invalid box: \"%.*s\"\n", (int)size, line);
+        st->invalid = true;
+        return;
+    }
+
+    day02_batch_push(&st->batch, dims, &st->totals);
+}
+
+enum stream_status day02_stream_feed(void *state, const char *chunk, size_t size)
+{
+    struct day02_stream *st = state;
+    return line_splitter_feed(&st->lines, chunk, size, day02_stream_line, st) ? STREAM_MORE : STREAM_ERROR;
+}
+
+long long day02_stream_finish(void *state)
+{
+    struct day02_stream *st = state;
+    line_splitter_finish(&st->lines, day02_stream_line, st);
+    day02_batch_flush(&st->batch, &st->totals);
+    bool overflow = st->part == 1 ? st->totals.paper_overflow : st->totals.ribbon_overflow;
+    long long total = st->invalid || overflow ? -1
+                    : st->part == 1 ? st->totals.paper : st->totals.ribbon;
+    free(st);
+    return total;
 }
 
 void day02_tests()
@@ -86,4 +318,59 @@ void day02_tests()
 
     assert(day02_ribbon("2x3x4") == 34);
     assert(day02_ribbon("1x1x10") == 14);
+
+    assert(day02_wrapping_paper("2x3x4\n1x1x10\n") == 58 + 43);
+    assert(day02_ribbon("2x3x4\n\n1x1x10") == 34 + 14);
+    assert(day02_wrapping_paper("") == 0);
+
+    // Every digit count the SWAR parser handles
+    const char *numbers[] = {"7", "42", "305", "1000", "98765", "123456", "1234567", "12345678"};
+    for (size_t i = 0; i < SIZE(numbers); i++) {
+        strv view = strv_from(numbers[i]);
+        int n;
+        assert(day02_parse_number(&view, &n));
+        assert(n == atoi(numbers[i]) && view.size == 0);
+    }
+
+    // Totals past the range of int, and boxes too big for the 32-bit
+    // lanes of the vector kernel
+    assert(day02_ribbon("1000x1000x1000\n1000x1000x1000\n1000x1000x1000") == 3 * (4000 + 1000000000LL));
+    assert(day02_wrapping_paper("2000000x2000000x2000000") == 7 * 4000000000000LL);
+    assert(day02_ribbon("2000000x2000000x2000000") == 8000000 + 8000000000000000000LL);
+
+    // Past the largest box the math fits, and totals that overflow
+    struct day02_totals big;
+    assert(!day02_solve("2000001x1x1", &big));
+    assert(!day02_solve("99999999x99999999x99999999", &big));
+    assert(day02_ribbon("2000000x2000000x2000000\n2000000x2000000x2000000") == -1);
+    assert(day02_wrapping_paper("2000000x2000000x2000000\n2000000x2000000x2000000") == 2 * 7 * 4000000000000LL);
+
+    // Vector and scalar kernels agree, including the leftover boxes
+    static struct day02_batch batch;
+    uint64_t x = 2015;
+    for (batch.size = 0; batch.size < 1000; batch.size++) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        batch.l[batch.size] = (uint32_t)(x >> 54);
+        batch.w[batch.size] = (uint32_t)(x >> 44) & 1023;
+        batch.h[batch.size] = (uint32_t)(x >> 34) & 1023;
+        batch.dims_or |= batch.l[batch.size] | batch.w[batch.size] | batch.h[batch.size];
+    }
+    for (size_t size = 0; size <= batch.size; size += 97) {
+        struct day02_batch part = batch;
+        part.size = size;
+        struct day02_totals scalar = {0}, vector = {0};
+        day02_totals_scalar(&part, 0, size, &scalar);
+        day02_batch_flush(&part, &vector);
+        assert(scalar.paper == vector.paper && scalar.ribbon == vector.ribbon);
+    }
+
+    // Strict format: three numbers, two 'x', nothing else on the line
+    const char *invalid[] = {
+        "2x3", "2x3x", "x2x3x4", "2x3x4x", "2X3x4", "2 x3x4", "2x3x4 ",
+        "-2x3x4", "+2x3x4", "2x3x4\r", "123456789x1x1", "2xx3x4",
+    };
+    for (size_t i = 0; i < SIZE(invalid); i++) {
+        struct day02_totals totals;
+        assert(!day02_solve(invalid[i], &totals));
+    }
 }
@@ -1,105 +1,496 @@
-typedef struct {
-    int x;
-    int y;
-} vec2;
+#include "zset.h"
 
-#define RAX_HSET_TYPE vec2
-#define RAX_HSET_NAME hsetv2
-#define RAX_HSET_EQUAL(X, Y) (X.x == Y.x && X.y == Y.y)
-#include "rax_hset.h"
+// Visited set engine. A pre-pass over the moves finds the bounding box
+// of the walk, which picks the cheapest set that can hold it: a flat
+// bitmap over the box, a bitmap of 64x64 tiles allocated as they are
+// first touched, or, when even the tile directory would be too big,
+// a zset of Morton keys. Bitmaps are counted with popcount at the end.
 
-int day03_visit(const char *input)
+#define DAY03_MAX_WALKERS 64
+
+// Directions per byte, and which bytes are valid moves
+static const int8_t day03_dx[256] = {['>'] = 1, ['<'] = -1};
+static const int8_t day03_dy[256] = {['^'] = 1, ['v'] = -1};
+static const bool day03_is_move[256] = {['^'] = true, ['>'] = true, ['v'] = true, ['<'] = true};
+
+struct day03_bounds {
+    int min_x, max_x;
+    int min_y, max_y;
+};
+
+// Flat bitmaps up to 128 MiB
+#define DAY03_FLAT_MAX_BITS (1ULL << 30)
+#define DAY03_TILE_BITS 6
+#define DAY03_TILE (1 << DAY03_TILE_BITS)
+
+enum day03_set_kind {
+    DAY03_FLAT,
+    DAY03_TILED,
+    DAY03_ZSET,
+};
+
+struct day03_visited {
+    enum day03_set_kind kind;
+    struct day03_bounds bounds;
+    size_t width;  // In cells for FLAT, in tiles for TILED
+    size_t height;
+    uint64_t *bits;
+    uint64_t **tiles;
+    struct zset set;
+};
+
+// Walk the moves with the given number of walkers taking turns, and
+// find the box around every house visited. Return false on a bad move.
+bool day03_find_bounds(strv sv, size_t n_walkers, struct day03_bounds *b)
 {
-    strv sv = strv_from(input);
+    assert(n_walkers >= 1 && n_walkers <= DAY03_MAX_WALKERS);
+    int x[DAY03_MAX_WALKERS] = {0};
+    int y[DAY03_MAX_WALKERS] = {0};
+    *b = (struct day03_bounds) {0};
 
-    int x = 0;
-    int y = 0;
-    hsetv2 visited = {0};
-    hsetv2_set(&visited, (vec2) {.x = x, .y = y});
+    size_t w = 0;
     for (size_t i = 0; i < sv.size; i++) {
-        // TODO: @RAX_LIB change to buf!
-        switch(sv.str[i]) {
-        case '^':
-            y++;
-            break;
-        case '>':
-            x++;
-            break;
-        case 'v':
-            y--;
-            break;
-        case '<':
-            x--;
-            break;
-        default:
-            fprintf(stderr, "Unexpected character: %c\n", sv.str[i]);
-            abort();
+        unsigned char c = (unsigned char)sv.str[i];
+        if (!day03_is_move[c]) {
+            fprintf(stderr, "Unexpected character: %c\n", c);
+            return false;
         }
 
-        hsetv2_set(&visited, (vec2) {.x = x, .y = y});
+        x[w] += day03_dx[c];
+        y[w] += day03_dy[c];
+        if (x[w] < b->min_x) b->min_x = x[w];
+        if (x[w] > b->max_x) b->max_x = x[w];
+        if (y[w] < b->min_y) b->min_y = y[w];
+        if (y[w] > b->max_y) b->max_y = y[w];
+
+        if (++w == n_walkers) w = 0;
+    }
+
+    return true;
+}
+
+// Pick the set for a walk of `steps` moves inside b. A bitmap only
+// pays off while it isn't much bigger than a hash set of that many
+// houses would be.
+bool day03_visited_init(struct day03_visited *v, const struct day03_bounds *b, size_t steps)
+{
+    *v = (struct day03_visited) {.bounds = *b};
+    uint64_t width = (uint64_t)((long long)b->max_x - b->min_x + 1);
+    uint64_t height = (uint64_t)((long long)b->max_y - b->min_y + 1);
+    uint64_t budget = 128 * ((uint64_t)steps + 1);
+    if (budget < (1 << 20)) budget = 1 << 20;
+
+    uint64_t cells = width > UINT64_MAX / height ? UINT64_MAX : width * height;
+    if (cells <= budget && cells <= DAY03_FLAT_MAX_BITS) {
+        v->kind = DAY03_FLAT;
+        v->width = width;
+        v->height = height;
+        v->bits = calloc((cells + 63) / 64, sizeof(*v->bits));
+        return v->bits != NULL;
+    }
+
+    uint64_t tiles_x = (width + DAY03_TILE - 1) / DAY03_TILE;
+    uint64_t tiles_y = (height + DAY03_TILE - 1) / DAY03_TILE;
+    if (tiles_x * tiles_y <= budget / 32) {
+        v->kind = DAY03_TILED;
+        v->width = tiles_x;
+        v->height = tiles_y;
+        v->tiles = calloc(tiles_x * tiles_y, sizeof(*v->tiles));
+        return v->tiles != NULL;
+    }
+
+    v->kind = DAY03_ZSET;
+    return true;
+}
+
+bool day03_visited_add(struct day03_visited *v, int x, int y)
+{
+    size_t col = (size_t)((long long)x - v->bounds.min_x);
+    size_t row = (size_t)((long long)y - v->bounds.min_y);
+
+    switch (v->kind) {
+    case DAY03_FLAT: {
+        size_t bit = row * v->width + col;
+        v->bits[bit / 64] |= 1ULL << (bit % 64);
+        return true;
+    }
+    case DAY03_TILED: {
+        uint64_t **tile = &v->tiles[(row >> DAY03_TILE_BITS) * v->width + (col >> DAY03_TILE_BITS)];
+        if (!*tile && !(*tile = calloc(DAY03_TILE, sizeof(**tile))))
+            return false;
+        (*tile)[row % DAY03_TILE] |= 1ULL << (col % DAY03_TILE);
+        return true;
+    }
+    case DAY03_ZSET:
+        return zset_add(&v->set, x, y);
+    }
+
+    return false;
+}
+
+size_t day03_popcount(const uint64_t *words, size_t n)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++)
+        count += (size_t)__builtin_popcountll(words[i]);
+    return count;
+}
+
+size_t day03_visited_count(const struct day03_visited *v)
+{
+    switch (v->kind) {
+    case DAY03_FLAT:
+        return day03_popcount(v->bits, (v->width * v->height + 63) / 64);
+    case DAY03_TILED: {
+        size_t count = 0;
+        for (size_t i = 0; i < v->width * v->height; i++)
+            if (v->tiles[i]) count += day03_popcount(v->tiles[i], DAY03_TILE);
+        return count;
+    }
+    case DAY03_ZSET:
+        return v->set.size;
     }
 
-    return visited.size;
+    return 0;
 }
 
-int day03_robo(const char *input)
+void day03_visited_destroy(struct day03_visited *v)
 {
+    free(v->bits);
+    if (v->tiles) {
+        for (size_t i = 0; i < v->width * v->height; i++)
+            free(v->tiles[i]);
+        free(v->tiles);
+    }
+    zset_destroy(&v->set);
+}
+
+// Count the houses visited by n_walkers walkers taking turns on the
+// moves in input, all starting at the origin. Return -1 on bad input.
+long long day03_count_houses(const char *input, size_t n_walkers)
+{
+    PROF_BEGIN(bounds, "day03/bounds");
     strv sv = strv_from(input);
+    struct day03_bounds b;
+    bool valid = day03_find_bounds(sv, n_walkers, &b);
+    PROF_END(bounds);
+    if (!valid) return -1;
 
-    int s_x = 0;
-    int s_y = 0;
-    int r_x = 0;
-    int r_y = 0;
-    hsetv2 santa = {0};
-    hsetv2 robo = {0};
+    PROF_BEGIN(solve, "day03/solve");
+    struct day03_visited visited;
+    bool ok = day03_visited_init(&visited, &b, sv.size);
+    ok = ok && day03_visited_add(&visited, 0, 0);
 
-    hsetv2_set(&santa, (vec2) {.x = s_x, .y = s_y});
-    hsetv2_set(&robo, (vec2) {.x = r_x, .y = r_y});
-    for (size_t i = 0; i < sv.size; i++) {
-        bool is_santa = i % 2 == 0;
-        switch(sv.str[i]) {
-        case '^':
-            if (is_santa)
-                s_y++;
-            else
-                r_y++;
-            break;
-        case '>':
-            if (is_santa)
-                s_x++;
-            else
-                r_x++;
-            break;
-        case 'v':
-            if (is_santa)
-                s_y--;
-            else
-                r_y--;
-            break;
-        case '<':
-            if (is_santa)
-                s_x--;
+    int x[DAY03_MAX_WALKERS] = {0};
+    int y[DAY03_MAX_WALKERS] = {0};
+    size_t w = 0;
+    for (size_t i = 0; ok && i < sv.size; i++) {
+        unsigned char c = (unsigned char)sv.str[i];
+        x[w] += day03_dx[c];
+        y[w] += day03_dy[c];
+        ok = day03_visited_add(&visited, x[w], y[w]);
+        if (++w == n_walkers) w = 0;
+    }
+    long long result = ok ? (long long)day03_visited_count(&visited) : -1;
+    PROF_END(solve);
+
+    PROF_BEGIN(teardown, "day03/teardown");
+    day03_visited_destroy(&visited);
+    PROF_END(teardown);
+
+    return result;
+}
+
+// Parallel version. The input is cut into one chunk per thread, and
+// walker i % n_walkers makes move i wherever the cuts fall.
+//
+// 1. Each chunk sums the moves of every walker, and tracks the box
+//    each walker stays in, relative to where it enters the chunk.
+// 2. An exclusive scan over the chunks gives every walker's position
+//    at the start of every chunk, and the bounding box of the walk.
+// 3. Each chunk walks again from those positions and marks houses.
+//    Bitmaps are shared and set atomically. The hash set is sharded by
+//    hash: each chunk fills its own set per shard, and the shards are
+//    then merged in parallel with a bulk union, one shard per thread.
+
+struct day03_chunk {
+    strv sv;
+    size_t offset;
+    size_t n_walkers;
+    size_t bad; // Index of the first bad move, or SIZE_MAX
+
+    int dx[DAY03_MAX_WALKERS];
+    int dy[DAY03_MAX_WALKERS];
+    struct day03_bounds bounds[DAY03_MAX_WALKERS];
+
+    int x[DAY03_MAX_WALKERS];
+    int y[DAY03_MAX_WALKERS];
+    struct day03_visited *visited;
+    struct zset *shards;
+    size_t n_shards;
+    bool ok;
+};
+
+void day03_chunk_sum(void *arg)
+{
+    struct day03_chunk *c = arg;
+    c->bad = SIZE_MAX;
+    for (size_t w = 0; w < c->n_walkers; w++) {
+        c->dx[w] = c->dy[w] = 0;
+        c->bounds[w] = (struct day03_bounds) {0};
+    }
+
+    size_t w = c->offset % c->n_walkers;
+    for (size_t i = 0; i < c->sv.size; i++) {
+        unsigned char ch = (unsigned char)c->sv.str[i];
+        if (!day03_is_move[ch]) {
+            c->bad = c->offset + i;
+            return;
+        }
+
+        int x = c->dx[w] += day03_dx[ch];
+        int y = c->dy[w] += day03_dy[ch];
+        struct day03_bounds *b = &c->bounds[w];
+        if (x < b->min_x) b->min_x = x;
+        if (x > b->max_x) b->max_x = x;
+        if (y < b->min_y) b->min_y = y;
+        if (y > b->max_y) b->max_y = y;
+
+        if (++w == c->n_walkers) w = 0;
+    }
+}
+
+// day03_visited_add for bitmaps shared between threads
+bool day03_visited_add_shared(struct day03_visited *v, int x, int y)
+{
+    size_t col = (size_t)((long long)x - v->bounds.min_x);
+    size_t row = (size_t)((long long)y - v->bounds.min_y);
+
+    uint64_t *word;
+    uint64_t mask;
+    if (v->kind == DAY03_FLAT) {
+        size_t bit = row * v->width + col;
+        word = &v->bits[bit / 64];
+        mask = 1ULL << (bit % 64);
+    } else {
+        uint64_t **slot = &v->tiles[(row >> DAY03_TILE_BITS) * v->width + (col >> DAY03_TILE_BITS)];
+        uint64_t *tile = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+        if (!tile) {
+            uint64_t *fresh = calloc(DAY03_TILE, sizeof(*fresh));
+            if (!fresh) return false;
+
+            // Someone else may have installed the tile first
+            if (__atomic_compare_exchange_n(slot, &tile, fresh, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                tile = fresh;
             else
-                r_x--;
+                free(fresh);
+        }
+        word = &tile[row % DAY03_TILE];
+        mask = 1ULL << (col % DAY03_TILE);
+    }
+
+    // Most houses are visited more than once, skip the locked op then
+    if (!(__atomic_load_n(word, __ATOMIC_RELAXED) & mask))
+        __atomic_fetch_or(word, mask, __ATOMIC_RELAXED);
+    return true;
+}
+
+size_t day03_shard(uint64_t key, size_t n_shards)
+{
+    return (size_t)((zset_hash(key) >> 32) % n_shards);
+}
+
+void day03_chunk_walk(void *arg)
+{
+    struct day03_chunk *c = arg;
+    bool ok = true;
+    size_t w = c->offset % c->n_walkers;
+    for (size_t i = 0; ok && i < c->sv.size; i++) {
+        unsigned char ch = (unsigned char)c->sv.str[i];
+        int x = c->x[w] += day03_dx[ch];
+        int y = c->y[w] += day03_dy[ch];
+
+        if (c->visited->kind == DAY03_ZSET) {
+            uint64_t key = zset_key(x, y);
+            ok = zset_add_key(&c->shards[day03_shard(key, c->n_shards)], key);
+        } else {
+            ok = day03_visited_add_shared(c->visited, x, y);
+        }
+
+        if (++w == c->n_walkers) w = 0;
+    }
+    c->ok = ok;
+}
+
+struct day03_merge {
+    struct day03_chunk *chunks;
+    size_t n_chunks;
+    size_t shard;
+    bool ok;
+};
+
+// Union shard s of every chunk into the first chunk's
+void day03_merge_shard(void *arg)
+{
+    struct day03_merge *m = arg;
+    struct zset *dst = &m->chunks[0].shards[m->shard];
+    m->ok = true;
+    for (size_t i = 1; m->ok && i < m->n_chunks; i++)
+        m->ok = zset_union(dst, &m->chunks[i].shards[m->shard]);
+}
+
+void day03_run(struct pool *pool, void (*fn)(void *), void *args, size_t size, size_t n)
+{
+    if (!pool) {
+        for (size_t i = 0; i < n; i++)
+            fn((char *)args + i * size);
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        pool_submit(pool, fn, (char *)args + i * size);
+    pool_wait(pool);
+}
+
+long long day03_count_houses_parallel(const char *input, size_t n_walkers, size_t n_threads)
+{
+    assert(n_walkers >= 1 && n_walkers <= DAY03_MAX_WALKERS);
+    if (n_threads <= 1)
+        return day03_count_houses(input, n_walkers);
+
+    strv sv = strv_from(input);
+    struct day03_chunk *chunks = calloc(n_threads, sizeof(*chunks));
+    struct day03_merge *merges = calloc(n_threads, sizeof(*merges));
+    struct pool pool;
+    if (!chunks || !merges || !pool_init(&pool, n_threads, 0)) {
+        free(chunks);
+        free(merges);
+        return -1;
+    }
+
+    PROF_BEGIN(bounds, "day03/bounds");
+    for (size_t i = 0; i < n_threads; i++) {
+        size_t start = sv.size * i / n_threads;
+        size_t end = sv.size * (i + 1) / n_threads;
+        chunks[i] = (struct day03_chunk) {
+            .sv = strv_from_range(sv.str, start, end),
+            .offset = start,
+            .n_walkers = n_walkers,
+        };
+    }
+    day03_run(&pool, day03_chunk_sum, chunks, sizeof(*chunks), n_threads);
+
+    int x[DAY03_MAX_WALKERS] = {0};
+    int y[DAY03_MAX_WALKERS] = {0};
+    struct day03_bounds b = {0};
+    bool valid = true;
+    for (size_t i = 0; valid && i < n_threads; i++) {
+        struct day03_chunk *c = &chunks[i];
+        if (c->bad != SIZE_MAX) {
+            fprintf(stderr, "Unexpected character: %c\n", sv.str[c->bad]);
+            valid = false;
             break;
-        default:
-            fprintf(stderr, "Unexpected character: %c\n", sv.str[i]);
-            abort();
         }
 
-        if (is_santa)
-            hsetv2_set(&santa, (vec2) {.x = s_x, .y = s_y});
-        else
-            hsetv2_set(&robo, (vec2) {.x = r_x, .y = r_y});
+        for (size_t w = 0; w < n_walkers; w++) {
+            c->x[w] = x[w];
+            c->y[w] = y[w];
+            if (x[w] + c->bounds[w].min_x < b.min_x) b.min_x = x[w] + c->bounds[w].min_x;
+            if (x[w] + c->bounds[w].max_x > b.max_x) b.max_x = x[w] + c->bounds[w].max_x;
+            if (y[w] + c->bounds[w].min_y < b.min_y) b.min_y = y[w] + c->bounds[w].min_y;
+            if (y[w] + c->bounds[w].max_y > b.max_y) b.max_y = y[w] + c->bounds[w].max_y;
+            x[w] += c->dx[w];
+            y[w] += c->dy[w];
+        }
+    }
+    PROF_END(bounds);
+
+    long long result = -1;
+    struct day03_visited visited = {0};
+    if (!valid || !day03_visited_init(&visited, &b, sv.size))
+        goto done;
+
+    PROF_BEGIN(solve, "day03/solve");
+    bool ok = true;
+    for (size_t i = 0; ok && i < n_threads; i++) {
+        chunks[i].visited = &visited;
+        if (visited.kind == DAY03_ZSET) {
+            chunks[i].n_shards = n_threads;
+            chunks[i].shards = calloc(n_threads, sizeof(*chunks[i].shards));
+            ok = chunks[i].shards != NULL;
+        }
+    }
+
+    // The origin is in no chunk
+    if (ok && visited.kind == DAY03_ZSET) {
+        uint64_t origin = zset_key(0, 0);
+        ok = zset_add_key(&chunks[0].shards[day03_shard(origin, n_threads)], origin);
+    } else if (ok) {
+        ok = day03_visited_add_shared(&visited, 0, 0);
+    }
+
+    if (ok) {
+        day03_run(&pool, day03_chunk_walk, chunks, sizeof(*chunks), n_threads);
+        for (size_t i = 0; i < n_threads; i++)
+            ok = ok && chunks[i].ok;
+    }
+
+    if (ok && visited.kind == DAY03_ZSET) {
+        for (size_t s = 0; s < n_threads; s++)
+            merges[s] = (struct day03_merge) {.chunks = chunks, .n_chunks = n_threads, .shard = s};
+        day03_run(&pool, day03_merge_shard, merges, sizeof(*merges), n_threads);
+
+        size_t count = 0;
+        for (size_t s = 0; s < n_threads; s++) {
+            ok = ok && merges[s].ok;
+            count += chunks[0].shards[s].size;
+        }
+        if (ok) result = (long long)count;
+    } else if (ok) {
+        result = (long long)day03_visited_count(&visited);
+    }
+    PROF_END(solve);
+
+done:;
+    PROF_BEGIN(teardown, "day03/teardown");
+    for (size_t i = 0; i < n_threads; i++) {
+        if (!chunks[i].shards) continue;
+        for (size_t s = 0; s < chunks[i].n_shards; s++)
+            zset_destroy(&chunks[i].shards[s]);
+        free(chunks[i].shards);
     }
+    day03_visited_destroy(&visited);
+    pool_destroy(&pool);
+    free(chunks);
+    free(merges);
+    PROF_END(teardown);
+
+    return result;
+}
 
-    // Join sets
-    // TODO: @RAX_LIB add method to library
-    hsetv2_it iter = hsetv2_iter(&santa);
-    while (hsetv2_next(&iter))
-        hsetv2_set(&robo, *iter.value);
+// Inputs below this are walked on one thread
+#define DAY03_PARALLEL_MIN (4 * 1024 * 1024)
 
-    return robo.size;
+long long day03_solve(const char *input, size_t n_walkers)
+{
+    size_t n_threads = strlen(input) >= DAY03_PARALLEL_MIN ? pool_default_threads() : 1;
+    return day03_count_houses_parallel(input, n_walkers, n_threads);
+}
+
+long long day03_visit(const char *input)
+{
+    return day03_solve(input, 1);
+}
+
+long long day03_robo(const char *input)
+{
+    return day03_solve(input, 2);
+}
+
+int day03_cmp_key(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
 }
 
 void day03_tests()
@@ -111,4 +502,143 @@ void day03_tests()
     assert(day03_robo("^v") == 3);
     assert(day03_robo("^>v<") == 3);
     assert(day03_robo("^v^v^v^v^v") == 11);
+
+    // The same walks through every kind of set
+    char walk[5000 + 1];
+    uint64_t r = 2015;
+    for (size_t i = 0; i < sizeof(walk) - 1; i++) {
+        r = r * 6364136223846793005ULL + 1442695040888963407ULL;
+        walk[i] = "^>v<"[r >> 62];
+    }
+    walk[sizeof(walk) - 1] = '\0';
+
+    // A straight line east and back: wide and flat
+    char line[2 * 3000 + 1];
+    memset(line, '>', 3000);
+    memset(line + 3000, '<', 3000);
+    line[sizeof(line) - 1] = '\0';
+
+    const char *walks[] = {walk, line, "^>v<"};
+    for (size_t i = 0; i < SIZE(walks); i++) {
+        for (size_t n_walkers = 1; n_walkers <= 3; n_walkers++) {
+            strv sv = strv_from(walks[i]);
+            struct day03_bounds b;
+            assert(day03_find_bounds(sv, n_walkers, &b));
+
+            size_t counts[3];
+            for (int kind = DAY03_FLAT; kind <= DAY03_ZSET; kind++) {
+                struct day03_visited v;
+                bool ok = day03_visited_init(&v, &b, sv.size);
+                assert(ok && v.kind == DAY03_FLAT);
+
+                // Force the kind under test
+                free(v.bits);
+                v = (struct day03_visited) {.kind = kind, .bounds = b};
+                size_t width = (size_t)(b.max_x - b.min_x + 1);
+                size_t height = (size_t)(b.max_y - b.min_y + 1);
+                if (kind == DAY03_FLAT) {
+                    v.width = width;
+                    v.height = height;
+                    v.bits = calloc((width * height + 63) / 64, sizeof(*v.bits));
+                } else if (kind == DAY03_TILED) {
+                    v.width = (width + DAY03_TILE - 1) / DAY03_TILE;
+                    v.height = (height + DAY03_TILE - 1) / DAY03_TILE;
+                    v.tiles = calloc(v.width * v.height, sizeof(*v.tiles));
+                }
+
+                int x[3] = {0}, y[3] = {0};
+                assert(day03_visited_add(&v, 0, 0));
+                for (size_t j = 0; j < sv.size; j++) {
+                    unsigned char c = (unsigned char)sv.str[j];
+                    x[j % n_walkers] += day03_dx[c];
+                    y[j % n_walkers] += day03_dy[c];
+                    assert(day03_visited_add(&v, x[j % n_walkers], y[j % n_walkers]));
+                }
+                counts[kind] = day03_visited_count(&v);
+                day03_visited_destroy(&v);
+            }
+
+            assert(counts[DAY03_FLAT] == counts[DAY03_TILED]);
+            assert(counts[DAY03_FLAT] == counts[DAY03_ZSET]);
+            assert((long long)counts[DAY03_FLAT] == day03_count_houses(walks[i], n_walkers));
+        }
+    }
+
+    // Any number of walkers on any number of threads, with every kind
+    // of set: the spiral is flat, the long line tiled and the diagonal
+    // hashed
+    size_t spiral_size = 0;
+    static char spiral[20000 + 1];
+    for (size_t arm = 1; spiral_size + 2 * arm <= sizeof(spiral) - 1; arm++)
+        for (size_t k = 0; k < 2 * arm; k++)
+            spiral[spiral_size++] = "^>v<"[(arm * 2 + k / arm) % 4];
+    spiral[spiral_size] = '\0';
+
+    static char long_line[100000 + 2000 + 1];
+    memset(long_line, '>', 100000);
+    memset(long_line + 100000, '^', 2000);
+    long_line[sizeof(long_line) - 1] = '\0';
+
+    static char diagonal[200000 + 1];
+    for (size_t i = 0; i < sizeof(diagonal) - 1; i++)
+        diagonal[i] = "^>"[i % 2];
+    diagonal[sizeof(diagonal) - 1] = '\0';
+
+    const char *kind_walks[] = {spiral, long_line, diagonal};
+    for (int kind = DAY03_FLAT; kind <= DAY03_ZSET; kind++) {
+        strv sv = strv_from(kind_walks[kind]);
+        struct day03_bounds b;
+        struct day03_visited v;
+        assert(day03_find_bounds(sv, 1, &b));
+        bool ok = day03_visited_init(&v, &b, sv.size);
+        assert(ok && v.kind == (enum day03_set_kind)kind);
+        day03_visited_destroy(&v);
+    }
+
+    const char *parallel_walks[] = {walk, line, spiral, long_line, diagonal, "^>v<", ""};
+    for (size_t i = 0; i < SIZE(parallel_walks); i++) {
+        size_t walkers[] = {1, 2, 3, DAY03_MAX_WALKERS};
+        for (size_t k = 0; k < SIZE(walkers); k++) {
+            long long expected = day03_count_houses(parallel_walks[i], walkers[k]);
+            for (size_t n_threads = 2; n_threads <= 3; n_threads++)
+                assert(day03_count_houses_parallel(parallel_walks[i], walkers[k], n_threads) == expected);
+        }
+    }
+
+    // zset against a sorted list of the same keys, around zero and at
+    // the extremes of int, split over two sets and merged
+    struct zset z = {0}, z2 = {0};
+    static int px[20000], py[20000];
+    static uint64_t keys[20000];
+    uint64_t r2 = 7;
+    for (size_t i = 0; i < SIZE(keys); i++) {
+        r2 = r2 * 6364136223846793005ULL + 1442695040888963407ULL;
+        px[i] = (int)(r2 >> 56) - 128, py[i] = (int)((r2 >> 48) & 255) - 128;
+        if (i % 100 == 0) px[i] = i % 200 ? INT_MAX - (int)i : INT_MIN + (int)i;
+        assert(zset_add(i % 2 ? &z : &z2, px[i], py[i]));
+        keys[i] = zset_key(px[i], py[i]);
+    }
+    assert(zset_union(&z, &z2) && z2.size == 0);
+    for (size_t i = 0; i < SIZE(keys); i++)
+        assert(zset_has(&z, px[i], py[i]));
+    qsort(keys, SIZE(keys), sizeof(*keys), day03_cmp_key);
+    size_t unique = 0;
+    for (size_t i = 0; i < SIZE(keys); i++)
+        unique += i == 0 || keys[i] != keys[i - 1];
+    assert(z.size == unique);
+    assert(!zset_has(&z, 1000, 1000) && !zset_has(&z2, 0, 0));
+    assert(zset_key(-1, 0) < zset_key(0, 0) && zset_key(0, 0) < zset_key(1, 0));
+    assert(zset_key(0, -1) < zset_key(0, 0) && zset_key(0, 0) < zset_key(0, 1));
+    zset_destroy(&z);
+
+    // Extents past the flat budget go to tiles, then to the hash set
+    struct day03_visited v;
+    struct day03_bounds wide = {.min_x = -100000, .max_x = 100000, .min_y = -1000, .max_y = 1000};
+    bool ok = day03_visited_init(&v, &wide, 200000);
+    assert(ok && v.kind == DAY03_TILED);
+    day03_visited_destroy(&v);
+    struct day03_bounds huge = {.min_x = INT_MIN, .max_x = INT_MAX, .min_y = INT_MIN, .max_y = INT_MAX};
+    ok = day03_visited_init(&v, &huge, 1000);
+    assert(ok && v.kind == DAY03_ZSET);
+    day03_visited_destroy(&v);
 }
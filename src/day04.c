@@ -1,67 +1,552 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "md5.h"
+#include "pool.h"
 #include "rax_strv.h"
 
-// This day involves md5 hashes which aren't trivial to implement. So
-// I will "cheat" and use the external `md5sum` program on Linux. But,
-// now these solutions only work on Linux.
-bool day04_get_md5hash(char *sum, size_t sum_size, const char *s)
+// Return true if the digest starts with at least `zeros` zero hex
+// digits. Works on the raw digest, so nothing gets formatted.
+bool day04_check_hash(const unsigned char digest[MD5_DIGEST_SIZE], int zeros)
 {
-    char cmd[1024];
-    snprintf(cmd, sizeof(cmd), "echo -n \"%s\" | md5sum", s);
+    assert(zeros >= 0 && zeros <= 2 * MD5_DIGEST_SIZE);
 
-    FILE *proc = popen(cmd, "r");
-    if (!proc) {
-        perror("Failed to open process");
+    for (int i = 0; i < zeros / 2; i++)
+        if (digest[i] != 0) return false;
+
+    if (zeros % 2 == 1 && (digest[zeros / 2] & 0xf0) != 0)
         return false;
+
+    return true;
+}
+
+// Bits of the first digest word (little endian) that hold the first
+// `zeros` hex digits, up to 8. Almost every candidate fails on this
+// word alone, before the digest is assembled.
+uint32_t day04_first_word_mask(int zeros)
+{
+    uint32_t mask = 0;
+    for (int i = 0; i < zeros && i < 8; i++)
+        mask |= (uint32_t)0xf << (8 * (i / 2) + (i % 2 == 0 ? 4 : 0));
+
+    return mask;
+}
+
+// Reference search, one md5() per candidate. Works for any secret.
+size_t day04_find_nonce_scalar(strv secret, int zeros)
+{
+    // Room for the secret and any 64-bit number
+    size_t cap = secret.size + 21;
+    char *input = malloc(cap);
+    assert(input);
+    memcpy(input, secret.str, secret.size);
+
+    unsigned char digest[MD5_DIGEST_SIZE];
+    size_t nonce = 1;
+    while (true) {
+        int n = snprintf(input + secret.size, cap - secret.size, "%zu", nonce);
+        md5(digest, input, secret.size + (size_t)n);
+        if (day04_check_hash(digest, zeros))
+            break;
+
+        nonce++;
     }
 
-    // Just assume it will fit in 1 line/call
-    char buf[1024];
-    fgets(buf, sizeof(buf), proc);
-    pclose(proc);
+    free(input);
+    return nonce;
+}
+
+// Write nonce in decimal to buf, without a terminator.
+// Return the number of digits.
+size_t day04_format_nonce(char *buf, size_t nonce)
+{
+    char tmp[20];
+    size_t n = 0;
+    do {
+        tmp[n++] = (char)('0' + nonce % 10);
+        nonce /= 10;
+    } while (nonce > 0);
+
+    for (size_t i = 0; i < n; i++)
+        buf[i] = tmp[n - 1 - i];
 
-    strv_it it = {0};
-    strv_split(&it, buf, "  -");
-    if (!strv_next(&it)) {
-        fprintf(stderr, "Failed to parse md5 hash\n");
-        return false;
+    return n;
+}
+
+// Every message starts with the secret, so all of its whole 64 byte
+// blocks are compressed once up front. A struct md5 that has been fed
+// the secret holds exactly that: the state after the whole blocks, and
+// the rest of the secret in buf.
+//
+// A candidate is the final block: the rest of the secret, the nonce in
+// decimal, and padding. When the tail of the secret leaves no room for
+// the digits and the length, the message spills into a second block.
+// Moving to the next nonce bumps the digits in place rather than
+// formatting the number again.
+struct day04_candidate {
+    unsigned char block[2 * MD5_BLOCK_SIZE];
+    size_t blocks; // 1 or 2
+    size_t digits; // Offset of the first digit
+    size_t end;    // Offset one past the last digit
+};
+
+// Pad the candidate into one or two blocks
+void day04_candidate_pad(struct day04_candidate *c, const struct md5 *prefix)
+{
+    uint64_t bits = (uint64_t)(prefix->size - c->digits + c->end) * 8;
+    c->blocks = c->end <= MD5_MAX_SINGLE_BLOCK ? 1 : 2;
+
+    size_t length = c->blocks * MD5_BLOCK_SIZE - 8;
+    c->block[c->end] = 0x80;
+    memset(c->block + c->end + 1, 0, length - c->end - 1);
+    for (int i = 0; i < 8; i++)
+        c->block[length + i] = (unsigned char)(bits >> (8 * i));
+}
+
+void day04_candidate_init(struct day04_candidate *c, const struct md5 *prefix, size_t nonce)
+{
+    size_t tail = prefix->size % MD5_BLOCK_SIZE;
+    memcpy(c->block, prefix->buf, tail);
+    c->digits = tail;
+    c->end = tail + day04_format_nonce((char *)c->block + tail, nonce);
+    day04_candidate_pad(c, prefix);
+}
+
+// Add delta (at most 9) to the nonce. Return the offset of the first
+// byte that changed.
+size_t day04_candidate_add(struct day04_candidate *c, const struct md5 *prefix, unsigned delta)
+{
+    assert(delta <= 9);
+
+    size_t i = c->end;
+    unsigned carry = delta;
+    while (carry > 0 && i > c->digits) {
+        i--;
+        unsigned digit = (unsigned)(c->block[i] - '0') + carry;
+        c->block[i] = (unsigned char)('0' + digit % 10);
+        carry = digit / 10;
     }
 
-    snprintf(sum, sum_size, strv_fmt, strv_arg(it.sv));
-    return true;
+    if (carry > 0) {
+        // 99.. -> 100..: one more digit, so the padding moves too
+        memmove(c->block + c->digits + 1, c->block + c->digits, c->end - c->digits);
+        c->block[c->digits] = (unsigned char)('0' + carry);
+        c->end++;
+        day04_candidate_pad(c, prefix);
+        return c->digits;
+    }
+
+    return i;
 }
 
-bool day04_check_hash(strv hash)
+// Copy the words of a candidate from byte offset `from` onwards into
+// lane l of the interleaved kernel input. The second block's words
+// follow the first's, interleaved the same way.
+void day04_candidate_store(uint32_t *m, size_t lanes, size_t l,
+                           const struct day04_candidate *c, size_t from)
 {
-    /* assert(hash.size >= 5); */
-    for (int i = 0; i < 5; i++)
-        if (hash.str[i] != '0') return false;
+    for (size_t w = from / 4; w < 16 * c->blocks; w++)
+        m[w * lanes + l] = md5_load_word(c->block + w * 4);
+}
 
-    return true;
+// Search nonces in [first, last), `kernel->lanes` of them per call of
+// the kernel. prefix must have been fed the secret. If limit is not
+// NULL, give up once every remaining nonce is >= *limit. Return the
+// lowest hit, or 0 if there is none. Adds the number of hashes computed
+// to *hashes.
+size_t day04_search_range(const struct md5_kernel *kernel, const struct md5 *prefix, int zeros,
+                          size_t first, size_t last, atomic_size_t *limit, size_t *hashes)
+{
+    size_t lanes = kernel->lanes;
+    uint32_t mask = day04_first_word_mask(zeros);
+    uint32_t m[2 * 16 * MD5_MAX_LANES];
+    uint32_t mid[4 * MD5_MAX_LANES];
+    uint32_t out[4 * MD5_MAX_LANES];
+    unsigned char digest[MD5_DIGEST_SIZE];
+
+    struct day04_candidate candidates[MD5_MAX_LANES];
+    for (size_t l = 0; l < lanes; l++) {
+        day04_candidate_init(&candidates[l], prefix, first + l);
+        day04_candidate_store(m, lanes, l, &candidates[l], 0);
+    }
+
+    for (size_t base = first; base < last; base += lanes) {
+        if (limit && base >= atomic_load_explicit(limit, memory_order_relaxed))
+            break;
+
+        if (base != first) {
+            for (size_t l = 0; l < lanes; l++) {
+                size_t from = day04_candidate_add(&candidates[l], prefix, (unsigned)lanes);
+                day04_candidate_store(m, lanes, l, &candidates[l], from);
+            }
+        }
+
+        // Lanes only disagree on the block count in the batch where the
+        // nonce grows the digit that spills it into a second block. The
+        // one block lanes of that batch read their digest from mid.
+        size_t blocks = 1;
+        for (size_t l = 0; l < lanes; l++)
+            if (candidates[l].blocks > blocks) blocks = candidates[l].blocks;
+
+        if (blocks == 1) {
+            kernel->compress(out, prefix->state, m);
+        } else {
+            kernel->compress(mid, prefix->state, m);
+            kernel->compress_lanes(out, mid, m + 16 * lanes);
+        }
+        *hashes += lanes;
+
+        // Lanes are in nonce order, so the first hit is the lowest
+        for (size_t l = 0; l < lanes && base + l < last; l++) {
+            const uint32_t *lane_out = candidates[l].blocks < blocks ? mid : out;
+            if (lane_out[l] & mask) continue;
+
+            for (size_t i = 0; i < MD5_DIGEST_SIZE; i++)
+                digest[i] = (unsigned char)(lane_out[(i / 4) * lanes + l] >> (8 * (i % 4)));
+
+            if (day04_check_hash(digest, zeros))
+                return base + l;
+        }
+    }
+
+    return 0;
 }
 
-void day04_tests()
+void day04_prefix_init(struct md5 *prefix, strv secret)
 {
-    /* char buf[1024]; */
-    /* const char *s = "abcdef609043"; */
-    /* assert(day04_get_md5hash(buf, sizeof(buf), s)); */
-    /* printf("sum = %s\n", buf); */
-    /* if (day04_check_hash(strv_from(buf))) */
-        /* printf("It's a match!\n"); */
-
-    const char *secret = "abcdef";
-    size_t i = 1;
-    char input[1024];
-    char hash[1024];
-    while (true) {
-        snprintf(input, sizeof(input), "%s%zu", secret, i);
-        printf("Try: %s\n", input);
+    md5_init(prefix);
+    md5_update(prefix, secret.str, secret.size);
+}
+
+size_t day04_find_nonce_kernel(const struct md5_kernel *kernel, strv secret, int zeros)
+{
+    struct md5 prefix;
+    day04_prefix_init(&prefix, secret);
+
+    size_t hashes = 0;
+    return day04_search_range(kernel, &prefix, zeros, 1, SIZE_MAX, NULL, &hashes);
+}
+
+// Parallel search. Workers claim blocks of nonces in increasing order
+// from a shared counter. A worker stops when the block it claims starts
+// at or above the best hit so far: every lower nonce has already been
+// claimed by someone, so the final best is the lowest hit overall.
+
+#define DAY04_BLOCK_NONCES (1 << 16)
+
+struct day04_search {
+    const struct md5_kernel *kernel;
+    struct md5 prefix;
+    int zeros;
+    size_t block_nonces;
+    atomic_size_t next; // First nonce of the next unclaimed block
+    atomic_size_t best; // Lowest hit so far, SIZE_MAX if none
+};
 
-        day04_get_md5hash(hash, sizeof(hash), input);
-        if (day04_check_hash(strv_from(hash)))
+struct day04_worker {
+    struct day04_search *search;
+    size_t hashes;
+    size_t blocks;
+    uint64_t ns;
+};
+
+void day04_worker_run(void *arg)
+{
+    struct day04_worker *worker = arg;
+    struct day04_search *search = worker->search;
+
+    uint64_t start = now_ns();
+    while (true) {
+        size_t first = atomic_fetch_add(&search->next, search->block_nonces);
+        if (first >= atomic_load(&search->best))
             break;
 
-        i++;
+        worker->blocks++;
+        size_t hit = day04_search_range(search->kernel, &search->prefix, search->zeros,
+                                        first, first + search->block_nonces,
+                                        &search->best, &worker->hashes);
+        if (hit == 0) continue;
+
+        size_t best = atomic_load(&search->best);
+        while (hit < best && !atomic_compare_exchange_weak(&search->best, &best, hit));
+    }
+    worker->ns = now_ns() - start;
+}
+
+// Search with n_threads workers, using the calling thread if there is
+// only one. workers must have room for n_threads entries, which are
+// filled with per thread counts.
+size_t day04_find_nonce_parallel(const struct md5_kernel *kernel, strv secret, int zeros,
+                                 size_t block_nonces, size_t n_threads,
+                                 struct day04_worker *workers)
+{
+    struct day04_search search = {
+        .kernel = kernel,
+        .zeros = zeros,
+        .block_nonces = block_nonces,
+    };
+    day04_prefix_init(&search.prefix, secret);
+    atomic_init(&search.next, 1);
+    atomic_init(&search.best, SIZE_MAX);
+
+    for (size_t i = 0; i < n_threads; i++)
+        workers[i] = (struct day04_worker) {.search = &search};
+
+    if (n_threads == 1) {
+        day04_worker_run(&workers[0]);
+    } else {
+        struct pool pool;
+        if (!pool_init(&pool, n_threads, 0)) {
+            // Still correct, just slower
+            n_threads = 1;
+            day04_worker_run(&workers[0]);
+        } else {
+            for (size_t i = 0; i < n_threads; i++)
+                pool_submit(&pool, day04_worker_run, &workers[i]);
+            pool_wait(&pool);
+            pool_destroy(&pool);
+        }
+    }
+
+    size_t best = atomic_load(&search.best);
+    assert(best != SIZE_MAX);
+    return best;
+}
+
+// Find the lowest positive nonce for which md5(secret || nonce) starts
+// with `zeros` zero hex digits, on all cores.
+size_t day04_find_nonce(strv secret, int zeros)
+{
+    size_t n_threads = pool_default_threads();
+    struct day04_worker *workers = calloc(n_threads, sizeof(*workers));
+    assert(workers);
+
+    const struct md5_kernel *kernel = md5_best_kernel();
+    size_t nonce = day04_find_nonce_parallel(kernel, secret, zeros, DAY04_BLOCK_NONCES,
+                                             n_threads, workers);
+
+#ifdef PROF
+    // Per thread throughput, for profiling builds only
+    size_t total = 0;
+    for (size_t i = 0; i < n_threads; i++) {
+        total += workers[i].hashes;
+        fprintf(stderr, "Thread %zu: %zu blocks, %8.2f Mhash/s\n", i, workers[i].blocks,
+                workers[i].ns ? (double)workers[i].hashes / ((double)workers[i].ns / 1e3) : 0.0);
+    }
+    fprintf(stderr, "%zu hashes with %s on %zu threads\n", total, kernel->name, n_threads);
+#endif
+
+    free(workers);
+    return nonce;
+}
+
+long long day04_mine(const char *input)
+{
+    PROF_ZONE("day04/solve");
+    return (long long)day04_find_nonce(strv_trim(strv_from(input)), 5);
+}
+
+long long day04_mine_2(const char *input)
+{
+    PROF_ZONE("day04/solve");
+    return (long long)day04_find_nonce(strv_trim(strv_from(input)), 6);
+}
+
+void day04_hex(char out[2 * MD5_DIGEST_SIZE + 1], const unsigned char digest[MD5_DIGEST_SIZE])
+{
+    for (size_t i = 0; i < MD5_DIGEST_SIZE; i++)
+        snprintf(out + 2 * i, 3, "%02x", digest[i]);
+}
+
+void day04_tests()
+{
+    // RFC 1321 test suite
+    struct {
+        const char *input;
+        const char *hash;
+    } vectors[] = {
+        {"", "d41d8cd98f00b204e9800998ecf8427e"},
+        {"a", "0cc175b9c0f1b6a831c399e269772661"},
+        {"abc", "900150983cd24fb0d6963f7d28e17f72"},
+        {"message digest", "f96b697d7cb7938d525a2f31aaf161d0"},
+        {"abcdefghijklmnopqrstuvwxyz", "c3fcd3d76192e4007dfb496cca67e13b"},
+        {"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",
+         "d174ab98d277d9f5a5611c2c9f419d9f"},
+        {"12345678901234567890123456789012345678901234567890123456789012345678901234567890",
+         "57edf4a22be3c955ac49da2e2107b67a"},
+    };
+
+    unsigned char digest[MD5_DIGEST_SIZE];
+    char hex[2 * MD5_DIGEST_SIZE + 1];
+    for (size_t i = 0; i < SIZE(vectors); i++) {
+        md5(digest, vectors[i].input, strlen(vectors[i].input));
+        day04_hex(hex, digest);
+        assert(strcmp(hex, vectors[i].hash) == 0);
+    }
+
+    // Same thing, fed in uneven pieces
+    const char *long_input = vectors[SIZE(vectors) - 1].input;
+    struct md5 ctx;
+    md5_init(&ctx);
+    for (size_t i = 0, step = 1; i < strlen(long_input); i += step, step += 3) {
+        size_t n = strlen(long_input) - i < step ? strlen(long_input) - i : step;
+        md5_update(&ctx, long_input + i, n);
     }
+    md5_final(&ctx, digest);
+    day04_hex(hex, digest);
+    assert(strcmp(hex, vectors[SIZE(vectors) - 1].hash) == 0);
+
+    // Every kernel this CPU supports must agree with md5()
+    for (size_t k = 0; k < SIZE(md5_kernels); k++) {
+        const struct md5_kernel *kernel = &md5_kernels[k];
+        if (!kernel->supported()) continue;
+
+        uint32_t m[16 * MD5_MAX_LANES];
+        uint32_t out[4 * MD5_MAX_LANES];
+        uint32_t words[16];
+        unsigned char block[MD5_BLOCK_SIZE];
+        for (size_t l = 0; l < kernel->lanes; l++) {
+            int n = snprintf((char *)block, sizeof(block), "lane %zu of %s", l, kernel->name);
+            md5_pad_block(block, (size_t)n);
+            md5_load_block(words, block);
+            for (size_t w = 0; w < 16; w++)
+                m[w * kernel->lanes + l] = words[w];
+        }
+
+        kernel->compress(out, md5_init_state, m);
+        for (size_t l = 0; l < kernel->lanes; l++) {
+            int n = snprintf((char *)block, sizeof(block), "lane %zu of %s", l, kernel->name);
+            md5(digest, block, (size_t)n);
+            for (size_t i = 0; i < MD5_DIGEST_SIZE; i++)
+                assert(digest[i] == (unsigned char)(out[(i / 4) * kernel->lanes + l] >> (8 * (i % 4))));
+        }
+
+        // Second blocks, each lane starting from its own state
+        char message[2 * MD5_BLOCK_SIZE];
+        uint32_t states[4 * MD5_MAX_LANES];
+        for (size_t l = 0; l < kernel->lanes; l++) {
+            size_t n = MD5_BLOCK_SIZE + 10 + 5 * l;
+            for (size_t i = 0; i < n; i++)
+                message[i] = (char)('A' + (i * 7 + l) % 26);
+
+            md5_init(&ctx);
+            md5_update(&ctx, message, MD5_BLOCK_SIZE);
+            for (size_t w = 0; w < 4; w++)
+                states[w * kernel->lanes + l] = ctx.state[w];
+
+            memcpy(block, message + MD5_BLOCK_SIZE, n - MD5_BLOCK_SIZE);
+            md5_pad_final_block(block, n - MD5_BLOCK_SIZE, n);
+            md5_load_block(words, block);
+            for (size_t w = 0; w < 16; w++)
+                m[w * kernel->lanes + l] = words[w];
+        }
+
+        kernel->compress_lanes(out, states, m);
+        for (size_t l = 0; l < kernel->lanes; l++) {
+            size_t n = MD5_BLOCK_SIZE + 10 + 5 * l;
+            for (size_t i = 0; i < n; i++)
+                message[i] = (char)('A' + (i * 7 + l) % 26);
+            md5(digest, message, n);
+            for (size_t i = 0; i < MD5_DIGEST_SIZE; i++)
+                assert(digest[i] == (unsigned char)(out[(i / 4) * kernel->lanes + l] >> (8 * (i % 4))));
+        }
+
+        assert(day04_find_nonce_kernel(kernel, strv_from("abcdef"), 4)
+               == day04_find_nonce_scalar(strv_from("abcdef"), 4));
+
+        // A 40 byte secret needs a second block once the nonce has 16
+        // digits, a 50 byte one from the 6th digit on
+        const char *secret40 = "0123456789abcdefghijklmnopqrstuvwxyzABCD";
+        assert(day04_find_nonce_kernel(kernel, strv_from(secret40), 3)
+               == day04_find_nonce_scalar(strv_from(secret40), 3));
+
+        const char *secret50 = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMN";
+        struct md5 prefix50;
+        day04_prefix_init(&prefix50, strv_from(secret50));
+        for (size_t first = 99990; first < 100010; first++) {
+            size_t hashes = 0;
+            size_t hit = day04_search_range(kernel, &prefix50, 1, first, first + 40, NULL, &hashes);
+            size_t expected_hit = 0;
+            for (size_t nonce = first; nonce < first + 40 && !expected_hit; nonce++) {
+                int n = snprintf(message, sizeof(message), "%s%zu", secret50, nonce);
+                md5(digest, message, (size_t)n);
+                if (day04_check_hash(digest, 1)) expected_hit = nonce;
+            }
+            assert(hit == expected_hit);
+        }
+    }
+
+    // The parallel search must find the same, lowest, nonce no matter
+    // how the blocks are split up and handed out
+    size_t expected = day04_find_nonce_scalar(strv_from("abcdef"), 4);
+    for (size_t n_threads = 1; n_threads <= 4; n_threads++) {
+        struct day04_worker workers[4];
+        assert(day04_find_nonce_parallel(md5_best_kernel(), strv_from("abcdef"), 4, 7,
+                                         n_threads, workers) == expected);
+        assert(day04_find_nonce_parallel(md5_best_kernel(), strv_from("abcdef"), 4, 1000,
+                                         n_threads, workers) == expected);
+    }
+
+    // Bumping the nonce in place must match formatting it from scratch,
+    // including when it grows a digit, and when that spills it into a
+    // second block
+    struct md5 prefix;
+    const char *bump_secrets[] = {"abcdef", "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMN"};
+    for (size_t s = 0; s < SIZE(bump_secrets); s++) {
+        day04_prefix_init(&prefix, strv_from(bump_secrets[s]));
+        struct day04_candidate bumped, fresh;
+        day04_candidate_init(&bumped, &prefix, 99995);
+        for (size_t nonce = 99995; nonce < 100020; nonce += 7) {
+            day04_candidate_init(&fresh, &prefix, nonce);
+            assert(bumped.end == fresh.end);
+            assert(bumped.blocks == fresh.blocks);
+            assert(memcmp(bumped.block, fresh.block, fresh.blocks * MD5_BLOCK_SIZE) == 0);
+            day04_candidate_add(&bumped, &prefix, 7);
+        }
+    }
+
+    // Secrets longer than a block, with short and long tails, against
+    // plain md5() of the whole message
+    for (size_t secret_size = 60; secret_size <= 140; secret_size += 40) {
+        char secret[256];
+        for (size_t i = 0; i < secret_size; i++)
+            secret[i] = (char)('a' + i % 26);
+
+        size_t nonce = 1;
+        char message[256];
+        while (true) {
+            memcpy(message, secret, secret_size);
+            int n = snprintf(message + secret_size, sizeof(message) - secret_size, "%zu", nonce);
+            md5(digest, message, secret_size + (size_t)n);
+            if (day04_check_hash(digest, 3)) break;
+            nonce++;
+        }
+
+        struct day04_worker workers[2];
+        assert(day04_find_nonce_parallel(md5_best_kernel(), strv_from_range(secret, 0, secret_size),
+                                         3, 100, 2, workers) == nonce);
+    }
+
+    assert(day04_first_word_mask(1) == 0xf0);
+    assert(day04_first_word_mask(5) == 0xf0ffff);
+    assert(day04_first_word_mask(12) == 0xffffffff);
+
+    // 7 and 8 zeros, beyond the puzzle
+    unsigned char zeros[MD5_DIGEST_SIZE] = {0, 0, 0, 0x0f, 0xff};
+    assert(day04_check_hash(zeros, 6));
+    assert(day04_check_hash(zeros, 7));
+    assert(!day04_check_hash(zeros, 8));
+
+    // 000001dbbfa3a5c83a2d506429c7b00e
+    md5(digest, "abcdef609043", strlen("abcdef609043"));
+    assert(day04_check_hash(digest, 5));
+    assert(!day04_check_hash(digest, 6));
 
-    printf("Solution: %zu -> %s\n", i, hash);
+    long long ans = day04_mine("abcdef\n");
+    assert(ans == 609043);
+    assert(day04_mine("pqrstuv") == 1048970);
+    printf("Solution: %lld\n", ans);
 }
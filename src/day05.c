@@ -2,13 +2,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include "rax_strv.h"
+#include "pool.h"
 
-#define RAX_HSET_TYPE             char *
-#define RAX_HSET_NAME             hsets
-#define RAX_HSET_HASH(X)          (RAX_HSET_HASH_FUN((X), strlen((X))))
-#define RAX_HSET_EQUAL(X, Y)      (strcmp((X), (Y)) == 0)
-#define RAX_HSET_DESTROY(X)       free(X)
-#include "rax_hset.h"
+#if defined(__x86_64__) || defined(__i386__)
+#define DAY05_X86
+#include <immintrin.h>
+#endif
 
 bool is_vowel(char c)
 {
@@ -44,72 +43,468 @@ bool is_string_nice(strv line)
     return n_vowels >= 3 && had_double;
 }
 
-bool is_string_nice_2(strv line)
+// Part 1 counting kernels. Each one counts the nice lines in s[0, size)
+// the same way is_string_nice does, splitting on '\n' like strv_lines.
+
+size_t day05_count_nice_scalar(const char *s, size_t size)
+{
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos <= size) {
+        const char *nl = memchr(s + pos, '\n', size - pos);
+        size_t len = nl ? (size_t)(nl - (s + pos)) : size - pos;
+        if (is_string_nice(strv_from_range(s, pos, pos + len))) count++;
+        pos += len + 1;
+    }
+    return count;
+}
+
+#ifdef DAY05_X86
+
+// Lines of up to 16 bytes are classified in vector registers, one line
+// per 128-bit lane. With next = the lane shifted down one byte:
+//
+// - vowels are five compares, counted with popcount
+// - a double letter is next == byte
+// - ab, cd, pq and xy are next == byte + 1 with byte in {a, c, p, x}
+//
+// Bytes past the end of a line are masked off by comparing the lane
+// index against the length. Longer lines go through is_string_nice.
+
+#define DAY05_LANE 16
+
+// Length of the line at s[pos, size), finding the newline in the 16
+// bytes at pos when they are readable.
+__attribute__((target("sse2")))
+static inline size_t day05_line_length(const char *s, size_t size, size_t pos, bool *short_line)
+{
+    if (pos + DAY05_LANE <= size) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + pos));
+        int nl = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+        if (nl) {
+            *short_line = true;
+            return (size_t)__builtin_ctz((unsigned)nl);
+        }
+        if (pos + DAY05_LANE == size || s[pos + DAY05_LANE] == '\n') {
+            *short_line = true;
+            return DAY05_LANE;
+        }
+    }
+
+    *short_line = false;
+    const char *nl = memchr(s + pos, '\n', size - pos);
+    return nl ? (size_t)(nl - (s + pos)) : size - pos;
+}
+
+// Nice flags of the lines in each 16-bit half of the masks
+static inline unsigned day05_nice_bits(unsigned vowels, unsigned doubles, unsigned forbidden, int lanes)
+{
+    unsigned nice = 0;
+    for (int l = 0; l < lanes; l++) {
+        unsigned shift = (unsigned)l * DAY05_LANE;
+        // Branchless, the outcome is close to random
+        unsigned ok = (__builtin_popcount((vowels >> shift) & 0xffff) >= 3)
+                    & (((doubles >> shift) & 0xffff) != 0)
+                    & (((forbidden >> shift) & 0xffff) == 0);
+        nice |= ok << l;
+    }
+    return nice;
+}
+
+__attribute__((target("sse2")))
+static inline bool day05_classify_sse2(const char *line, size_t len)
+{
+    const __m128i index = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i v = _mm_loadu_si128((const __m128i *)line);
+    __m128i next = _mm_srli_si128(v, 1);
+    __m128i n = _mm_set1_epi8((char)len);
+    __m128i in_line = _mm_cmpgt_epi8(n, index);
+    __m128i pair_in_line = _mm_cmpgt_epi8(n, _mm_add_epi8(index, _mm_set1_epi8(1)));
+
+    __m128i vowels = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('a')), _mm_cmpeq_epi8(v, _mm_set1_epi8('e'))),
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('i')), _mm_cmpeq_epi8(v, _mm_set1_epi8('o'))),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8('u'))));
+    __m128i doubles = _mm_cmpeq_epi8(next, v);
+    __m128i first = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('a')), _mm_cmpeq_epi8(v, _mm_set1_epi8('c'))),
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('p')), _mm_cmpeq_epi8(v, _mm_set1_epi8('x'))));
+    __m128i forbidden = _mm_and_si128(first, _mm_cmpeq_epi8(_mm_sub_epi8(next, v), _mm_set1_epi8(1)));
+
+    return day05_nice_bits((unsigned)_mm_movemask_epi8(_mm_and_si128(vowels, in_line)),
+                           (unsigned)_mm_movemask_epi8(_mm_and_si128(doubles, pair_in_line)),
+                           (unsigned)_mm_movemask_epi8(_mm_and_si128(forbidden, pair_in_line)), 1);
+}
+
+// Two lines at once, one per 128-bit lane
+__attribute__((target("avx2")))
+static inline unsigned day05_classify_avx2(const char *a, size_t len_a, const char *b, size_t len_b)
+{
+    const __m256i index = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                                           0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)a)),
+                                        _mm_loadu_si128((const __m128i *)b), 1);
+    __m256i next = _mm256_srli_si256(v, 1);
+    __m256i n = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_set1_epi8((char)len_a)),
+                                        _mm_set1_epi8((char)len_b), 1);
+    __m256i in_line = _mm256_cmpgt_epi8(n, index);
+    __m256i pair_in_line = _mm256_cmpgt_epi8(n, _mm256_add_epi8(index, _mm256_set1_epi8(1)));
+
+    __m256i vowels = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('a')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('e'))),
+        _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('i')),
+                                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('o'))),
+                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('u'))));
+    __m256i doubles = _mm256_cmpeq_epi8(next, v);
+    __m256i first = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('a')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('c'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('p')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('x'))));
+    __m256i forbidden = _mm256_and_si256(first, _mm256_cmpeq_epi8(_mm256_sub_epi8(next, v), _mm256_set1_epi8(1)));
+
+    return day05_nice_bits((unsigned)_mm256_movemask_epi8(_mm256_and_si256(vowels, in_line)),
+                           (unsigned)_mm256_movemask_epi8(_mm256_and_si256(doubles, pair_in_line)),
+                           (unsigned)_mm256_movemask_epi8(_mm256_and_si256(forbidden, pair_in_line)), 2);
+}
+
+__attribute__((target("sse2")))
+size_t day05_count_nice_sse2(const char *s, size_t size)
+{
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos <= size) {
+        bool short_line;
+        size_t len = day05_line_length(s, size, pos, &short_line);
+        if (short_line)
+            count += day05_classify_sse2(s + pos, len);
+        else
+            count += is_string_nice(strv_from_range(s, pos, pos + len));
+        pos += len + 1;
+    }
+    return count;
+}
+
+__attribute__((target("avx2")))
+size_t day05_count_nice_avx2(const char *s, size_t size)
+{
+    size_t count = 0;
+    size_t pos = 0;
+    const char *held = NULL; // A short line waiting for a partner
+    size_t held_len = 0;
+    while (pos <= size) {
+        bool short_line;
+        size_t len = day05_line_length(s, size, pos, &short_line);
+        if (!short_line) {
+            count += is_string_nice(strv_from_range(s, pos, pos + len));
+        } else if (held) {
+            count += (size_t)__builtin_popcount(day05_classify_avx2(held, held_len, s + pos, len));
+            held = NULL;
+        } else {
+            held = s + pos;
+            held_len = len;
+        }
+        pos += len + 1;
+    }
+
+    // The partner of the last one is an empty line
+    if (held)
+        count += day05_classify_avx2(held, held_len, held, 0) & 1;
+    return count;
+}
+
+bool day05_sse2_supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+}
+
+bool day05_avx2_supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif // DAY05_X86
+
+bool day05_always_supported(void)
+{
+    return true;
+}
+
+struct day05_kernel {
+    const char *name;
+    size_t (*count)(const char *s, size_t size);
+    bool (*supported)(void);
+};
+
+// Widest first
+const struct day05_kernel day05_kernels[] = {
+#ifdef DAY05_X86
+    {"avx2", day05_count_nice_avx2, day05_avx2_supported},
+    {"sse2", day05_count_nice_sse2, day05_sse2_supported},
+#endif
+    {"scalar", day05_count_nice_scalar, day05_always_supported},
+};
+
+const struct day05_kernel *day05_best_kernel(void)
+{
+    for (size_t i = 0; i < SIZE(day05_kernels); i++)
+        if (day05_kernels[i].supported())
+            return &day05_kernels[i];
+
+    return &day05_kernels[SIZE(day05_kernels) - 1];
+}
+
+// Part 2. Every letter pair of a line gets the index where it first
+// appeared; seeing it again at least two characters later is a repeat
+// that doesn't overlap. The table is stamped with a line number instead
+// of being cleared per line.
+
+#define DAY05_PAIRS (26 * 26)
+
+struct day05_pairs {
+    uint32_t line;
+    uint32_t stamp[DAY05_PAIRS];
+    uint32_t first[DAY05_PAIRS];
+};
+
+// Lines with anything but lowercase letters, which the table can't index
+bool day05_nice_2_slow(strv line)
 {
-    hsets pairs = {0};
     bool has_double_pair = false;
     bool has_sandwiched = false;
-    for (size_t i = 0; i < line.size; i++) {
-        if (i == 0) continue;
+    for (size_t i = 1; i < line.size; i++) {
+        for (size_t j = 1; !has_double_pair && j + 1 < i; j++)
+            has_double_pair = line.str[j - 1] == line.str[i - 1] && line.str[j] == line.str[i];
 
-        // Pairs
-        // TODO: @RAX_LIB Make dedicated strv map?
-        strv pair = strv_slice(line, i - 1, i + 1);
-        if (!has_double_pair && hsets_in(&pairs, strv_to_cstr_temp(pair))) {
-            // Need to check that we are not overlapping
-            //                 v       v
-            // But consider: aaa vs aaaa
-            // aaa will never satisfy, so we need to be at least 4 chars deep
-            if (i > 2) {
-                strv prev_pair = strv_slice(line, i - 2, i);
-                strv prev_prev_pair = strv_slice(line, i - 3, i - 1);
-                if (!strv_eq(pair, prev_pair)) {
-                    has_double_pair = true;
-                } else if (strv_eq(pair, prev_prev_pair)) {
-                    has_double_pair = true;
-                }
-            }
-        } else {
-            hsets_set(&pairs, strv_to_cstr_owned(pair));
+        if (i + 1 < line.size && line.str[i - 1] == line.str[i + 1])
+            has_sandwiched = true;
+    }
+
+    return has_double_pair && has_sandwiched;
+}
+
+bool day05_nice_2(struct day05_pairs *pairs, strv line)
+{
+    if (line.size > UINT32_MAX)
+        return day05_nice_2_slow(line);
+
+    if (++pairs->line == 0) {
+        memset(pairs, 0, sizeof(*pairs));
+        pairs->line = 1;
+    }
+
+    bool has_double_pair = false;
+    bool has_sandwiched = false;
+    for (size_t i = 1; i < line.size; i++) {
+        unsigned a = (unsigned char)line.str[i - 1] - 'a';
+        unsigned b = (unsigned char)line.str[i] - 'a';
+        if (a >= 26 || b >= 26)
+            return day05_nice_2_slow(line);
+
+        unsigned pair = a * 26 + b;
+        if (pairs->stamp[pair] != pairs->line) {
+            pairs->stamp[pair] = pairs->line;
+            pairs->first[pair] = (uint32_t)i;
+        } else if (i - pairs->first[pair] >= 2) {
+            has_double_pair = true;
         }
 
-        // Repeat
-        if (!has_sandwiched && i < line.size - 1)
-            has_sandwiched = line.str[i - 1] == line.str[i + 1];
+        if (i + 1 < line.size && line.str[i - 1] == line.str[i + 1])
+            has_sandwiched = true;
     }
 
-    hsets_destroy(&pairs);
     return has_double_pair && has_sandwiched;
 }
 
-int day05_nice_strings(const char *input)
+size_t day05_count_nice_2(struct day05_pairs *pairs, const char *s, size_t size)
+{
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos <= size) {
+        const char *nl = memchr(s + pos, '\n', size - pos);
+        size_t len = nl ? (size_t)(nl - (s + pos)) : size - pos;
+        count += day05_nice_2(pairs, strv_from_range(s, pos, pos + len));
+        pos += len + 1;
+    }
+    return count;
+}
+
+// Large inputs are split into newline-aligned chunks, one per worker,
+// and their counts summed. A solver only runs its own part's kernel.
+// When both parts are wanted, as by microbench, they share one pass
+// over memory: each chunk is cut into blocks small enough to stay in
+// cache, and each block gets both counts before moving on.
+
+enum day05_parts {
+    DAY05_PART_1 = 1,
+    DAY05_PART_2 = 2,
+    DAY05_BOTH_PARTS = DAY05_PART_1 | DAY05_PART_2,
+};
+
+struct day05_counts {
+    long long nice;   // Only counted with DAY05_PART_1
+    long long nice_2; // Only counted with DAY05_PART_2
+};
+
+#define DAY05_BLOCK (64 * 1024)
+
+// Index just past the first newline at or after pos, or size
+size_t day05_next_line(const char *s, size_t size, size_t pos)
+{
+    if (pos >= size) return size;
+    const char *nl = memchr(s + pos, '\n', size - pos);
+    return nl ? (size_t)(nl - s) + 1 : size;
+}
+
+void day05_count_parts(const char *s, size_t size, size_t block, enum day05_parts parts,
+                       struct day05_counts *counts)
 {
-    strv_it it = {0};
-    strv_lines(&it, input);
+    *counts = (struct day05_counts) {0};
+    if (parts == DAY05_PART_1) {
+        counts->nice = (long long)day05_best_kernel()->count(s, size);
+        return;
+    }
 
-    int lines = 0;
-    int nice_lines = 0;
-    while (strv_next(&it)) {
-        lines++;
-        if (is_string_nice(it.sv)) nice_lines++;
+    struct day05_pairs pairs = {0};
+    if (parts == DAY05_PART_2) {
+        counts->nice_2 = (long long)day05_count_nice_2(&pairs, s, size);
+        return;
     }
 
-    return nice_lines;
+    const struct day05_kernel *kernel = day05_best_kernel();
+    size_t pos = 0;
+    while (pos < size) {
+        size_t end = day05_next_line(s, size, pos + block);
+        counts->nice += (long long)kernel->count(s + pos, end - pos);
+        counts->nice_2 += (long long)day05_count_nice_2(&pairs, s + pos, end - pos);
+        pos = end;
+    }
 }
 
-int day05_nice_strings_2(const char *input)
+struct day05_chunk {
+    const char *s;
+    size_t size;
+    size_t block;
+    enum day05_parts parts;
+    struct day05_counts counts;
+};
+
+void day05_chunk_run(void *arg)
 {
-    strv_it it = {0};
-    strv_lines(&it, input);
+    struct day05_chunk *chunk = arg;
+    day05_count_parts(chunk->s, chunk->size, chunk->block, chunk->parts, &chunk->counts);
+}
+
+// Return false if no worker could be started
+bool day05_count_parallel(const char *s, size_t size, size_t n_threads, size_t block,
+                          enum day05_parts parts, struct day05_counts *counts)
+{
+    *counts = (struct day05_counts) {0};
+    if (n_threads <= 1) {
+        day05_count_parts(s, size, block, parts, counts);
+        return true;
+    }
+
+    struct day05_chunk *chunks = calloc(n_threads, sizeof(*chunks));
+    struct pool pool;
+    if (!chunks || !pool_init(&pool, n_threads, 0)) {
+        free(chunks);
+        return false;
+    }
+
+    size_t start = 0;
+    for (size_t i = 0; i < n_threads; i++) {
+        size_t end = i + 1 == n_threads ? size : day05_next_line(s, size, size / n_threads * (i + 1));
+        if (end < start) end = start;
+        chunks[i] = (struct day05_chunk) {.s = s + start, .size = end - start, .block = block, .parts = parts};
+        pool_submit(&pool, day05_chunk_run, &chunks[i]);
+        start = end;
+    }
+    pool_wait(&pool);
+    pool_destroy(&pool);
+
+    for (size_t i = 0; i < n_threads; i++) {
+        counts->nice += chunks[i].counts.nice;
+        counts->nice_2 += chunks[i].counts.nice_2;
+    }
+    free(chunks);
+    return true;
+}
+
+// Inputs below this are classified on one thread, part by part
+#define DAY05_PARALLEL_MIN (4 * 1024 * 1024)
+
+long long day05_nice_strings(const char *input)
+{
+    PROF_ZONE("day05/solve");
+    size_t size = strlen(input);
+    if (size < DAY05_PARALLEL_MIN)
+        return (long long)day05_best_kernel()->count(input, size);
+
+    struct day05_counts counts;
+    bool ok = day05_count_parallel(input, size, pool_default_threads(), DAY05_BLOCK, DAY05_PART_1, &counts);
+    return ok ? counts.nice : -1;
+}
 
-    int lines = 0;
-    int nice_lines = 0;
-    while (strv_next(&it)) {
-        lines++;
-        if (is_string_nice_2(it.sv)) nice_lines++;
+long long day05_nice_strings_2(const char *input)
+{
+    PROF_ZONE("day05/solve");
+    size_t size = strlen(input);
+    if (size < DAY05_PARALLEL_MIN) {
+        struct day05_pairs pairs = {0};
+        return (long long)day05_count_nice_2(&pairs, input, size);
     }
 
-    return nice_lines;
+    struct day05_counts counts;
+    bool ok = day05_count_parallel(input, size, pool_default_threads(), DAY05_BLOCK, DAY05_PART_2, &counts);
+    return ok ? counts.nice_2 : -1;
+}
+
+struct day05_stream {
+    int part;
+    size_t nice_lines;
+    struct day05_pairs pairs;
+    struct line_splitter lines;
+};
+
+void *day05_stream_init_part(int part)
+{
+    struct day05_stream *st = calloc(1, sizeof(*st));
+    if (st) st->part = part;
+    return st;
+}
+
+void *day05_stream_init(void)
+{
+    return day05_stream_init_part(1);
+}
+
+void *day05_stream_init_2(void)
+{
+    return day05_stream_init_part(2);
+}
+
+void day05_stream_line(void *ctx, const char *line, size_t size)
+{
+    struct day05_stream *st = ctx;
+    strv view = strv_from_range(line, 0, size);
+    if (st->part == 1 ? is_string_nice(view) : day05_nice_2(&st->pairs, view))
+        st->nice_lines++;
+}
+
+enum stream_status day05_stream_feed(void *state, const char *chunk, size_t size)
+{
+    struct day05_stream *st = state;
+    return line_splitter_feed(&st->lines, chunk, size, day05_stream_line, st) ? STREAM_MORE : STREAM_ERROR;
+}
+
+long long day05_stream_finish(void *state)
+{
+    struct day05_stream *st = state;
+    line_splitter_finish(&st->lines, day05_stream_line, st);
+    size_t nice_lines = st->nice_lines;
+    free(st);
+    return (long long)nice_lines;
 }
 
 void day05_tests()
@@ -120,8 +515,90 @@ void day05_tests()
     assert(!is_string_nice(strv_from("haegwjzuvuyypxyu")));
     assert(!is_string_nice(strv_from("dvszwmarrgswjxmb")));
 
-    assert(is_string_nice_2(strv_from("qjhvhtzxzqqjkmpb")));
-    assert(is_string_nice_2(strv_from("xxyxx")));
-    assert(!is_string_nice_2(strv_from("uurcxstgmygtbstg")));
-    assert(!is_string_nice_2(strv_from("ieodomkazucvgmuy")));
+    // Every kernel against is_string_nice, on lines of every length up
+    // to past a vector lane, with and without a final newline
+    static char text[64 * 1024];
+    size_t size = 0;
+    size_t expected = 0;
+    uint64_t x = 2015;
+    for (size_t n = 0; size < sizeof(text) - 64; n++) {
+        size_t len = n % 23;
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        for (size_t i = 0; i < len; i++) {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+            // Skewed towards vowels and the forbidden pairs
+            text[size + i] = "aeiouabcdpqxyzzq"[x >> 60];
+        }
+        expected += is_string_nice(strv_from_range(text, size, size + len));
+        size += len;
+        text[size++] = '\n';
+    }
+    text[size] = '\0';
+
+    for (size_t k = 0; k < SIZE(day05_kernels); k++) {
+        if (!day05_kernels[k].supported()) continue;
+        assert(day05_kernels[k].count(text, size) == expected);
+        assert(day05_kernels[k].count(text, size - 1) == expected);
+        for (size_t cut = 0; cut < 200; cut += 7) {
+            size_t scalar = day05_count_nice_scalar(text, cut);
+            assert(day05_kernels[k].count(text, cut) == scalar);
+        }
+    }
+
+    struct day05_pairs pairs = {0};
+    assert(day05_nice_2(&pairs, strv_from("qjhvhtzxzqqjkmpb")));
+    assert(day05_nice_2(&pairs, strv_from("xxyxx")));
+    assert(!day05_nice_2(&pairs, strv_from("uurcxstgmygtbstg")));
+    assert(!day05_nice_2(&pairs, strv_from("ieodomkazucvgmuy")));
+
+    // Overlaps, and the table against the slow path on lines with and
+    // without letters it can't index
+    const char *lines_2[] = {
+        "aaa", "aaaa", "aaxa", "xyxy", "aaaxa", "abab", "abba", "", "a", "xyx",
+        "aa-aa", "a-a-a", "AbAAbA", "q\x80q\x80",
+    };
+    for (size_t i = 0; i < SIZE(lines_2); i++) {
+        strv line = strv_from(lines_2[i]);
+        assert(day05_nice_2(&pairs, line) == day05_nice_2_slow(line));
+    }
+    assert(day05_nice_2(&pairs, strv_from("aaaa")));
+    assert(!day05_nice_2(&pairs, strv_from("aaaxa")));
+    assert(day05_nice_2(&pairs, strv_from("xyxy")));
+    assert(!day05_nice_2(&pairs, strv_from("aaa")));
+
+    // Chunked counts match the plain ones wherever the cuts fall
+    struct day05_pairs fresh = {0};
+    long long expected_2 = (long long)day05_count_nice_2(&fresh, text, size);
+    size_t blocks[] = {1, 100, 4096, DAY05_BLOCK};
+    for (size_t n_threads = 1; n_threads <= 7; n_threads += 2) {
+        for (size_t b = 0; b < SIZE(blocks); b++) {
+            struct day05_counts counts;
+            assert(day05_count_parallel(text, size, n_threads, blocks[b], DAY05_BOTH_PARTS, &counts));
+            assert(counts.nice == (long long)expected && counts.nice_2 == expected_2);
+            assert(day05_count_parallel("ugknbfddgicrmopn", 16, n_threads, blocks[b], DAY05_BOTH_PARTS, &counts));
+            assert(counts.nice == 1 && counts.nice_2 == 0);
+            assert(day05_count_parallel("", 0, n_threads, blocks[b], DAY05_BOTH_PARTS, &counts));
+            assert(counts.nice == 0 && counts.nice_2 == 0);
+
+            // One part only leaves the other count alone
+            assert(day05_count_parallel(text, size, n_threads, blocks[b], DAY05_PART_1, &counts));
+            assert(counts.nice == (long long)expected && counts.nice_2 == 0);
+            assert(day05_count_parallel(text, size, n_threads, blocks[b], DAY05_PART_2, &counts));
+            assert(counts.nice == 0 && counts.nice_2 == expected_2);
+        }
+    }
+
+    // The same table across lines, and across the stamp wrapping around
+    uint64_t r = 2015;
+    pairs.line = UINT32_MAX - 500;
+    for (size_t n = 0; n < 1000; n++) {
+        char line[12];
+        size_t len = n % sizeof(line);
+        for (size_t i = 0; i < len; i++) {
+            r = r * 6364136223846793005ULL + 1442695040888963407ULL;
+            line[i] = "abcab"[(r >> 32) % 5];
+        }
+        strv sv = strv_from_range(line, 0, len);
+        assert(day05_nice_2(&pairs, sv) == day05_nice_2_slow(sv));
+    }
 }
@@ -1,164 +1,395 @@
-bool day06_turn_on(bool cur)
+// Lights are counted on a compressed grid. The x and y edges of every
+// rectangle cut the plane into strips, and every cell between the cuts
+// is lit the same way by every instruction, so it is handled once and
+// weighted by its area. The cost depends on the number of instructions,
+// not on the size of the grid.
+
+enum day06_op {
+    DAY06_ON,
+    DAY06_OFF,
+    DAY06_TOGGLE,
+};
+
+struct day06_rect {
+    enum day06_op op;
+    long long x0, y0; // Inclusive corners
+    long long x1, y1;
+};
+
+// Coordinates up to this keep any lit area within a long long. Part 2
+// brightness can still overflow, so its sums are checked.
+#define DAY06_MAX_COORD 999999999LL
+
+bool day06_parse_number(strv *sv, long long *n)
 {
-    (void)cur;
+    size_t i = 0;
+    long long value = 0;
+    for (; i < sv->size && sv->str[i] >= '0' && sv->str[i] <= '9'; i++) {
+        value = value * 10 + (sv->str[i] - '0');
+        if (value > DAY06_MAX_COORD) return false;
+    }
+
+    if (i == 0) return false;
+    *sv = strv_chop_left(*sv, i);
+    *n = value;
     return true;
 }
 
-bool day06_turn_off(bool cur)
+bool day06_parse_word(strv *sv, const char *word)
 {
-    (void)cur;
-    return false;
+    strv w = strv_from(word);
+    if (!strv_starts_with(*sv, w)) return false;
+    *sv = strv_chop_left(*sv, w.size);
+    return true;
 }
 
-bool day06_toggle(bool cur)
+bool day06_parse_coord(strv *sv, long long *x, long long *y)
 {
-    return !cur;
+    return day06_parse_number(sv, x) && day06_parse_word(sv, ",") && day06_parse_number(sv, y);
 }
 
-strv day06_parse_coord(strv instruction, int *x, int *y)
+// Parse "<op> X,Y through X,Y"
+bool day06_parse_rect(strv instruction, struct day06_rect *r)
 {
-    // Forgo error checking...
-    char *end = NULL;
-    *x = strtol(instruction.str, &end, 10);
+    strv sv = strv_trim(instruction);
+    if (day06_parse_word(&sv, "turn on "))
+        r->op = DAY06_ON;
+    else if (day06_parse_word(&sv, "turn off "))
+        r->op = DAY06_OFF;
+    else if (day06_parse_word(&sv, "toggle "))
+        r->op = DAY06_TOGGLE;
+    else
+        return false;
 
-    // +1 for the ,
-    instruction = strv_chop_left(instruction, 1 + (end - instruction.str));
-    *y = strtol(instruction.str, &end, 10);
+    return day06_parse_coord(&sv, &r->x0, &r->y0)
+        && day06_parse_word(&sv, " through ")
+        && day06_parse_coord(&sv, &r->x1, &r->y1)
+        && sv.size == 0;
+}
 
-    instruction = strv_chop_left(instruction, end - instruction.str);
-    return strv_trim_left(instruction);
+struct day06_lights {
+    struct day06_rect *rects;
+    size_t size;
+    size_t cap;
+    bool invalid;
+};
+
+// Add the instruction on one line. Blank lines are skipped.
+// Return false on a bad instruction or when out of memory.
+bool day06_lights_add(struct day06_lights *l, strv line)
+{
+    if (strv_is_empty(strv_trim(line)))
+        return true;
+
+    struct day06_rect r;
+    if (!day06_parse_rect(line, &r)) {
+        fprintf(stderr, "Unexpected instruction: \""strv_fmt"\"\n", strv_arg(line));
+        l->invalid = true;
+        return false;
+    }
+
+    // Backwards corners cover nothing
+    if (r.x0 > r.x1 || r.y0 > r.y1)
+        return true;
+
+    if (l->size == l->cap) {
+        size_t new_cap = l->cap ? l->cap * 2 : 64;
+        struct day06_rect *new_rects = realloc(l->rects, new_cap * sizeof(*new_rects));
+        if (!new_rects) {
+            l->invalid = true;
+            return false;
+        }
+        l->rects = new_rects;
+        l->cap = new_cap;
+    }
+
+    l->rects[l->size++] = r;
+    return true;
+}
+
+void day06_lights_destroy(struct day06_lights *l)
+{
+    free(l->rects);
+    *l = (struct day06_lights) {0};
+}
+
+int day06_cmp_coord(const void *a, const void *b)
+{
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
 }
 
-void day06_run_instruction(bool *grid, strv instruction)
+// Sort and dedup the n cuts, return how many are left
+size_t day06_unique_cuts(long long *cuts, size_t n)
 {
-    const strv TURN_ON = strv_from("turn on");
-    const strv TURN_OFF = strv_from("turn off");
-    const strv TOGGLE = strv_from("toggle");
+    qsort(cuts, n, sizeof(*cuts), day06_cmp_coord);
+    size_t unique = 0;
+    for (size_t i = 0; i < n; i++)
+        if (unique == 0 || cuts[unique - 1] != cuts[i])
+            cuts[unique++] = cuts[i];
+    return unique;
+}
 
-    bool (*op)(bool) = NULL;
-    if (strv_starts_with(instruction, TURN_ON)) {
-        op = day06_turn_on;
-        instruction = strv_trim_left(strv_chop_left(instruction, TURN_ON.size));
-    } else if (strv_starts_with(instruction, TURN_OFF)) {
-        op = day06_turn_off;
-        instruction = strv_trim_left(strv_chop_left(instruction, TURN_OFF.size));
-    } else if (strv_starts_with(instruction, TOGGLE)) {
-        op = day06_toggle;
-        instruction = strv_trim_left(strv_chop_left(instruction, TOGGLE.size));
-    } else {
-        fprintf(stderr, "Unexpected instruction: \""strv_fmt"\"\n", strv_arg(instruction));
-        abort();
+size_t day06_cut_index(const long long *cuts, size_t n, long long coord)
+{
+    long long *found = bsearch(&coord, cuts, n, sizeof(*cuts), day06_cmp_coord);
+    assert(found);
+    return (size_t)(found - cuts);
+}
+
+// Indices into the cuts of each rectangle's edges
+struct day06_span {
+    size_t x0, x1;
+    size_t y0, y1;
+};
+
+// Part 1 counts lit lights, part 2 the total brightness.
+// Return -1 when out of memory or when the brightness overflows.
+long long day06_lights_count(const struct day06_lights *l, int part)
+{
+    size_t n = l->size;
+    if (n == 0) return 0;
+
+    PROF_BEGIN(compress, "day06/compress");
+    long long *xs = malloc(2 * n * sizeof(*xs));
+    long long *ys = malloc(2 * n * sizeof(*ys));
+    struct day06_span *spans = malloc(n * sizeof(*spans));
+    uint32_t *cells = calloc(2 * n, sizeof(*cells));
+    if (!xs || !ys || !spans || !cells) {
+        free(xs);
+        free(ys);
+        free(spans);
+        free(cells);
+        return -1;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        xs[2 * i] = l->rects[i].x0;
+        xs[2 * i + 1] = l->rects[i].x1 + 1;
+        ys[2 * i] = l->rects[i].y0;
+        ys[2 * i + 1] = l->rects[i].y1 + 1;
     }
+    size_t nx = day06_unique_cuts(xs, 2 * n);
+    size_t ny = day06_unique_cuts(ys, 2 * n);
 
-    int x0, y0;
-    instruction = day06_parse_coord(instruction, &x0, &y0);
-    assert(x0 >= 0 && y0 >= 0);
+    for (size_t i = 0; i < n; i++) {
+        spans[i] = (struct day06_span) {
+            .x0 = day06_cut_index(xs, nx, l->rects[i].x0),
+            .x1 = day06_cut_index(xs, nx, l->rects[i].x1 + 1),
+            .y0 = day06_cut_index(ys, ny, l->rects[i].y0),
+            .y1 = day06_cut_index(ys, ny, l->rects[i].y1 + 1),
+        };
+    }
+    PROF_END(compress);
 
-    instruction = strv_chop_left(instruction, strlen("through"));
-    instruction = strv_trim_left(instruction);
+    // One x strip at a time, replaying the instructions that cover it
+    // over its row of y cells
+    PROF_BEGIN(solve, "day06/solve");
+    long long total = 0;
+    bool overflow = false;
+    for (size_t x = 0; x + 1 < nx && !overflow; x++) {
+        memset(cells, 0, (ny - 1) * sizeof(*cells));
+        for (size_t i = 0; i < n; i++) {
+            const struct day06_span *s = &spans[i];
+            if (x < s->x0 || x >= s->x1) continue;
 
-    int x1, y1;
-    instruction = day06_parse_coord(instruction, &x1, &y1);
-    assert(x1 >= 0 && y1 >= 0);
+            uint32_t *c = cells;
+            switch (l->rects[i].op) {
+            case DAY06_ON:
+                if (part == 1)
+                    for (size_t y = s->y0; y < s->y1; y++) c[y] = 1;
+                else
+                    for (size_t y = s->y0; y < s->y1; y++) c[y] += 1;
+                break;
+            case DAY06_OFF:
+                if (part == 1)
+                    for (size_t y = s->y0; y < s->y1; y++) c[y] = 0;
+                else
+                    for (size_t y = s->y0; y < s->y1; y++) c[y] -= c[y] > 0;
+                break;
+            case DAY06_TOGGLE:
+                if (part == 1)
+                    for (size_t y = s->y0; y < s->y1; y++) c[y] ^= 1;
+                else
+                    for (size_t y = s->y0; y < s->y1; y++) c[y] += 2;
+                break;
+            }
+        }
 
-    for (size_t i = (size_t)x0; i <= (size_t)x1; i++)
-        for (size_t j = (size_t)y0; j <= (size_t)y1; j++)
-            grid[i * 1000 + j] = op(grid[i * 1000 + j]);
+        long long strip = 0, area;
+        for (size_t y = 0; y + 1 < ny; y++) {
+            overflow |= __builtin_mul_overflow((long long)cells[y], ys[y + 1] - ys[y], &area);
+            overflow |= __builtin_add_overflow(strip, area, &strip);
+        }
+        overflow |= __builtin_mul_overflow(strip, xs[x + 1] - xs[x], &area);
+        overflow |= __builtin_add_overflow(total, area, &total);
+    }
+    PROF_END(solve);
+
+    free(xs);
+    free(ys);
+    free(spans);
+    free(cells);
+    return overflow ? -1 : total;
 }
 
-int day06_count_lights(const char *input)
+long long day06_count_part(const char *input, int part)
 {
+    PROF_BEGIN(parse, "day06/parse");
     strv_it it = {0};
     strv_lines(&it, input);
 
-    bool grid[1000 * 1000] = {0};
-    while (strv_next(&it))
-        if (!strv_is_empty(strv_trim(it.sv)))
-            day06_run_instruction(grid, it.sv);
-
-    int count = 0;
-    for (size_t i = 0; i < 1000; i++)
-        for (size_t j = 0; j < 1000; j++)
-            if (grid[i * 1000 + j]) count++;
+    struct day06_lights lights = {0};
+    while (strv_next(&it) && day06_lights_add(&lights, it.sv));
+    PROF_END(parse);
 
+    long long count = lights.invalid ? -1 : day06_lights_count(&lights, part);
+    day06_lights_destroy(&lights);
     return count;
 }
 
-int day06_turn_on_2(int n)
+long long day06_count_lights(const char *input)
 {
-    return n + 1;
+    return day06_count_part(input, 1);
 }
 
-int day06_turn_off_2(int n)
+long long day06_count_lights_2(const char *input)
 {
-    return (--n < 0) ? 0 : n;
+    return day06_count_part(input, 2);
 }
 
-int day06_toggle_2(int n)
+// Streaming versions collect the instructions as their lines complete
+// and count at the end.
+struct day06_stream {
+    int part;
+    struct day06_lights lights;
+    struct line_splitter lines;
+};
+
+void *day06_stream_init_part(int part)
 {
-    return n + 2;
+    struct day06_stream *st = calloc(1, sizeof(*st));
+    if (st) st->part = part;
+    return st;
 }
 
-void day06_run_instruction_2(int *grid, strv instruction)
+void *day06_stream_init(void)
 {
-    const strv TURN_ON = strv_from("turn on");
-    const strv TURN_OFF = strv_from("turn off");
-    const strv TOGGLE = strv_from("toggle");
+    return day06_stream_init_part(1);
+}
 
-    int (*op)(int) = NULL;
-    if (strv_starts_with(instruction, TURN_ON)) {
-        op = day06_turn_on_2;
-        instruction = strv_trim_left(strv_chop_left(instruction, TURN_ON.size));
-    } else if (strv_starts_with(instruction, TURN_OFF)) {
-        op = day06_turn_off_2;
-        instruction = strv_trim_left(strv_chop_left(instruction, TURN_OFF.size));
-    } else if (strv_starts_with(instruction, TOGGLE)) {
-        op = day06_toggle_2;
-        instruction = strv_trim_left(strv_chop_left(instruction, TOGGLE.size));
-    } else {
-        fprintf(stderr, "Unexpected instruction: \""strv_fmt"\"\n", strv_arg(instruction));
-        abort();
-    }
+void *day06_stream_init_2(void)
+{
+    return day06_stream_init_part(2);
+}
 
-    int x0, y0;
-    instruction = day06_parse_coord(instruction, &x0, &y0);
-    assert(x0 >= 0 && y0 >= 0);
+void day06_stream_line(void *ctx, const char *line, size_t size)
+{
+    struct day06_stream *st = ctx;
+    if (!st->lights.invalid)
+        day06_lights_add(&st->lights, strv_from_range(line, 0, size));
+}
 
-    instruction = strv_chop_left(instruction, strlen("through"));
-    instruction = strv_trim_left(instruction);
+enum stream_status day06_stream_feed(void *state, const char *chunk, size_t size)
+{
+    struct day06_stream *st = state;
+    return line_splitter_feed(&st->lines, chunk, size, day06_stream_line, st) ? STREAM_MORE : STREAM_ERROR;
+}
 
-    int x1, y1;
-    instruction = day06_parse_coord(instruction, &x1, &y1);
-    assert(x1 >= 0 && y1 >= 0);
+long long day06_stream_finish(void *state)
+{
+    struct day06_stream *st = state;
+    line_splitter_finish(&st->lines, day06_stream_line, st);
 
-    for (size_t i = (size_t)x0; i <= (size_t)x1; i++)
-        for (size_t j = (size_t)y0; j <= (size_t)y1; j++)
-            grid[i * 1000 + j] = op(grid[i * 1000 + j]);
+    long long count = st->lights.invalid ? -1 : day06_lights_count(&st->lights, st->part);
+    day06_lights_destroy(&st->lights);
+    free(st);
+    return count;
 }
 
-int day06_count_lights_2(const char *input)
+// Brute force over a small grid, to check the compressed one
+long long day06_count_naive(const char *input, int part, size_t grid)
 {
+    struct day06_lights lights = {0};
     strv_it it = {0};
     strv_lines(&it, input);
-
-    int grid[1000 * 1000] = {0};
     while (strv_next(&it))
-        if (!strv_is_empty(strv_trim(it.sv)))
-            day06_run_instruction_2(grid, it.sv);
+        assert(day06_lights_add(&lights, it.sv));
 
-    int count = 0;
-    for (size_t i = 0; i < 1000; i++)
-        for (size_t j = 0; j < 1000; j++)
-            count += grid[i * 1000 + j];
+    int *cells = calloc(grid * grid, sizeof(*cells));
+    assert(cells);
+    for (size_t i = 0; i < lights.size; i++) {
+        const struct day06_rect *r = &lights.rects[i];
+        for (long long x = r->x0; x <= r->x1; x++) {
+            for (long long y = r->y0; y <= r->y1; y++) {
+                int *c = &cells[(size_t)x * grid + (size_t)y];
+                if (r->op == DAY06_ON) *c = part == 1 ? 1 : *c + 1;
+                else if (r->op == DAY06_OFF) *c = part == 1 ? 0 : (*c > 0 ? *c - 1 : 0);
+                else *c = part == 1 ? !*c : *c + 2;
+            }
+        }
+    }
 
-    return count;
+    long long total = 0;
+    for (size_t i = 0; i < grid * grid; i++)
+        total += cells[i];
+    free(cells);
+    day06_lights_destroy(&lights);
+    return total;
 }
 
 void day06_tests()
 {
-    /* bool grid[1000 * 1000] = {0}; */
-    /* day06_run_instruction(grid, strv_from("turn on 0,0 through 999,999")); */
-    /* int count = day06_count_lights(grid, 1000); */
-    /* printf("count = %d\n", count); */
-    /* day06_run_instruction(grid, strv_from("toggle 0,0 through 999,0")); */
+    assert(day06_count_lights("turn on 0,0 through 999,999") == 1000000);
+    assert(day06_count_lights("turn on 0,0 through 999,999\ntoggle 0,0 through 999,0") == 999000);
+    assert(day06_count_lights("turn on 0,0 through 999,999\nturn off 499,499 through 500,500\n") == 999996);
+    assert(day06_count_lights_2("turn on 0,0 through 0,0") == 1);
+    assert(day06_count_lights_2("toggle 0,0 through 999,999") == 2000000);
+    assert(day06_count_lights_2("turn off 0,0 through 9,9\nturn on 0,0 through 1,1") == 4);
+    assert(day06_count_lights("") == 0);
+
+    // Grids far past 1000x1000
+    assert(day06_count_lights("turn on 0,0 through 999999,999999") == 1000000000000LL);
+    assert(day06_count_lights_2("toggle 0,0 through 999999999,999999999\n"
+                                "turn off 0,0 through 999999999,999999999") == 1000000000000000000LL);
+
+    // Five full-size toggles are 1e19 of brightness, past LLONG_MAX,
+    // whether the grid is one strip or split into several
+    const char *full = "toggle 0,0 through 999999999,999999999\n";
+    char five[5 * 64] = "";
+    for (int i = 0; i < 5; i++) strcat(five, full);
+    assert(day06_count_lights_2(five) == -1);
+    assert(day06_count_lights(five) == 1000000000000000000LL);
+    char split[5 * 64 + 64] = "toggle 0,0 through 0,999999999\n";
+    strcat(split, five);
+    assert(day06_count_lights_2(split) == -1);
+
+    // Bad instructions
+    const char *invalid[] = {
+        "turn on 0,0", "turn 0,0 through 1,1", "toggle 0,0 through 1,1 please",
+        "toggle -1,0 through 1,1", "toggle 0,0 through 1000000000,1",
+    };
+    for (size_t i = 0; i < SIZE(invalid); i++)
+        assert(day06_count_lights(invalid[i]) == -1);
+
+    // Random instructions against the brute force
+    static char text[64 * 64];
+    uint64_t r = 2015;
+    for (size_t round = 0; round < 20; round++) {
+        size_t size = 0;
+        for (size_t i = 0; i < round * 3; i++) {
+            long long c[4];
+            for (size_t k = 0; k < 4; k++) {
+                r = r * 6364136223846793005ULL + 1442695040888963407ULL;
+                c[k] = (long long)((r >> 33) % 40);
+            }
+            const char *ops[] = {"turn on", "turn off", "toggle"};
+            size += (size_t)snprintf(text + size, sizeof(text) - size, "%s %lld,%lld through %lld,%lld\n",
+                                     ops[(r >> 20) % 3], c[0], c[1], c[2], c[3]);
+        }
+        text[size] = '\0';
+
+        assert(day06_count_lights(text) == day06_count_naive(text, 1, 40));
+        assert(day06_count_lights_2(text) == day06_count_naive(text, 2, 40));
+    }
 }
@@ -346,8 +346,9 @@ void day07_free_inst(struct day07_inst *inst)
         free(inst->input2.identifier);
 }
 
-int day07_run_instructions(const char *input)
+long long day07_run_instructions(const char *input)
 {
+    PROF_BEGIN(parse, "day07/parse");
     strv_it lines = {0};
     strv_lines(&lines, input);
 
@@ -364,7 +365,9 @@ int day07_run_instructions(const char *input)
         day07_dump_parsed_instruction(lines.sv, inst);
 #endif
     }
+    PROF_END(parse);
 
+    PROF_BEGIN(solve, "day07/solve");
     htsu signals = {0};
     while (da_size(insts) > 0) {
         // Iterate from the back to have fewer element shifts on removal
@@ -381,15 +384,19 @@ int day07_run_instructions(const char *input)
     uint16_t *rp = htsu_get(&signals, "a");
     assert(rp && "a does not exist in the map!");
     int result = (int)*rp;
+    PROF_END(solve);
 
+    PROF_BEGIN(teardown, "day07/teardown");
     htsu_destroy(&signals);
     da_free(insts);
+    PROF_END(teardown);
 
     return result;
 }
 
-int day07_run_instructions_2(const char *input)
+long long day07_run_instructions_2(const char *input)
 {
+    PROF_BEGIN(parse, "day07/parse");
     strv_it lines = {0};
     strv_lines(&lines, input);
 
@@ -406,7 +413,9 @@ int day07_run_instructions_2(const char *input)
         day07_dump_parsed_instruction(lines.sv, inst);
 #endif
     }
+    PROF_END(parse);
 
+    PROF_BEGIN(solve, "day07/solve");
     // Need to make a clone of insts before we destroy it during
     // instruction execution
     struct day07_inst *insts_clone = NULL;
@@ -461,10 +470,13 @@ int day07_run_instructions_2(const char *input)
     a_ptr = htsu_get(&signals, "a");
     assert(a_ptr && "a does not exist in the map!");
     int result = (int)*a_ptr;
+    PROF_END(solve);
 
+    PROF_BEGIN(teardown, "day07/teardown");
     htsu_destroy(&signals);
     da_free(insts);
     da_free(insts_clone);
+    PROF_END(teardown);
 
     return result;
 }
@@ -1,16 +1,16 @@
 
 
-int count_literal_chars(strv sv)
+size_t count_literal_chars(strv sv)
 {
     size_t count = 0;
     for (size_t i = 0; i < sv.size; i++)
         count++;
 
     /* printf("literal count: %zu\n", count); */
-    return (int)count; // == sv.size ?
+    return count; // == sv.size ?
 }
 
-int count_in_mem_chars(strv sv)
+size_t count_in_mem_chars(strv sv)
 {
     size_t count = 0;
     for (size_t i = 0; i < sv.size; i++) {
@@ -31,22 +31,23 @@ int count_in_mem_chars(strv sv)
     }
 
     /* printf("memory count: %zu\n", count); */
-    return (int)count;
+    return count;
 }
 
-int day08_count_chars(const char *input)
+long long day08_count_chars(const char *input)
 {
+    PROF_ZONE("day08/solve");
     strv_it lines = {0};
     strv_lines(&lines, input);
 
-    int lit_count = 0;
-    int in_mem_count = 0;
+    size_t lit_count = 0;
+    size_t in_mem_count = 0;
     while (strv_next(&lines) && !strv_is_empty(lines.sv)) {
         lit_count += count_literal_chars(lines.sv);
         in_mem_count += count_in_mem_chars(lines.sv);
     }
 
-    return lit_count - in_mem_count;
+    return (long long)(lit_count - in_mem_count);
 }
 
 char *day08_encode(strv sv)
@@ -66,13 +67,14 @@ char *day08_encode(strv sv)
     return da;
 }
 
-int day08_count_chars_2(const char *input)
+long long day08_count_chars_2(const char *input)
 {
+    PROF_ZONE("day08/solve");
     strv_it lines = {0};
     strv_lines(&lines, input);
 
-    int lit_count = 0;
-    int encoded_count = 0;
+    size_t lit_count = 0;
+    size_t encoded_count = 0;
     while (strv_next(&lines) && !strv_is_empty(lines.sv)) {
         lit_count += count_literal_chars(lines.sv);
         char *encoded = day08_encode(lines.sv);
@@ -80,7 +82,66 @@ int day08_count_chars_2(const char *input)
         da_free(encoded);
     }
 
-    return encoded_count - lit_count;
+    return (long long)(encoded_count - lit_count);
+}
+
+struct day08_stream {
+    int part;
+    long long count;
+    bool done; // Like the non-streaming version, stop at the first empty line
+    struct line_splitter lines;
+};
+
+void *day08_stream_init_part(int part)
+{
+    struct day08_stream *st = calloc(1, sizeof(*st));
+    if (st) st->part = part;
+    return st;
+}
+
+void *day08_stream_init(void)
+{
+    return day08_stream_init_part(1);
+}
+
+void *day08_stream_init_2(void)
+{
+    return day08_stream_init_part(2);
+}
+
+void day08_stream_line(void *ctx, const char *line, size_t size)
+{
+    struct day08_stream *st = ctx;
+    strv view = strv_from_range(line, 0, size);
+    if (st->done || strv_is_empty(view)) {
+        st->done = true;
+        return;
+    }
+
+    if (st->part == 1) {
+        st->count += (long long)(count_literal_chars(view) - count_in_mem_chars(view));
+    } else {
+        char *encoded = day08_encode(view);
+        st->count += (long long)(count_literal_chars(strv_from(encoded)) - count_literal_chars(view));
+        da_free(encoded);
+    }
+}
+
+enum stream_status day08_stream_feed(void *state, const char *chunk, size_t size)
+{
+    struct day08_stream *st = state;
+    if (!line_splitter_feed(&st->lines, chunk, size, day08_stream_line, st))
+        return STREAM_ERROR;
+    return st->done ? STREAM_DONE : STREAM_MORE;
+}
+
+long long day08_stream_finish(void *state)
+{
+    struct day08_stream *st = state;
+    line_splitter_finish(&st->lines, day08_stream_line, st);
+    long long count = st->count;
+    free(st);
+    return count;
 }
 
 void day08_tests()
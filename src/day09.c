@@ -1,3 +1,10 @@
+#define RAX_HSET_TYPE             char *
+#define RAX_HSET_NAME             hsets
+#define RAX_HSET_HASH(X)          (RAX_HSET_HASH_FUN((X), strlen((X))))
+#define RAX_HSET_EQUAL(X, Y)      (strcmp((X), (Y)) == 0)
+#define RAX_HSET_DESTROY(X)       free(X)
+#include "rax_hset.h"
+
 #define RAX_HT_KEY_TYPE             char *
 #define RAX_HT_VALUE_TYPE           int
 #define RAX_HT_HASH(KEY)            (RAX_HT_HASH_FUN((KEY), strlen((KEY))))
@@ -54,8 +61,9 @@ int day09_find_shortest_route(char **cities_arr, const htsi *distances)
     return res;
 }
 
-int day09_solution(const char *input)
+long long day09_solution(const char *input)
 {
+    PROF_BEGIN(parse, "day09/parse");
     // Parse distances
     hsets cities = {0};
     htsi distances = {0};
@@ -96,13 +104,18 @@ int day09_solution(const char *input)
     hsets_it it = hsets_iter(&cities);
     while (hsets_next(&it))
         da_append(cities_arr, *it.value);
+    PROF_END(parse);
 
+    PROF_BEGIN(solve, "day09/solve");
     int day09_shortest_path = day09_find_shortest_route(cities_arr, &distances);
+    PROF_END(solve);
     printf("Shortest path = %d\n", day09_shortest_path);
 
+    PROF_BEGIN(teardown, "day09/teardown");
     da_free(cities_arr);
     hsets_destroy(&cities);
     htsi_destroy(&distances);
+    PROF_END(teardown);
 
     return day09_shortest_path;
 }
@@ -144,8 +157,9 @@ int day09_find_longest_route(char **cities_arr, const htsi *distances)
     return res;
 }
 
-int day09_solution_2(const char *input)
+long long day09_solution_2(const char *input)
 {
+    PROF_BEGIN(parse, "day09/parse");
     // Parse distances
     hsets cities = {0};
     htsi distances = {0};
@@ -186,13 +200,18 @@ int day09_solution_2(const char *input)
     hsets_it it = hsets_iter(&cities);
     while (hsets_next(&it))
         da_append(cities_arr, *it.value);
+    PROF_END(parse);
 
+    PROF_BEGIN(solve, "day09/solve");
     int day09_longest_path = day09_find_longest_route(cities_arr, &distances);
+    PROF_END(solve);
     printf("Longest path = %d\n", day09_longest_path);
 
+    PROF_BEGIN(teardown, "day09/teardown");
     da_free(cities_arr);
     hsets_destroy(&cities);
     htsi_destroy(&distances);
+    PROF_END(teardown);
 
     return day09_longest_path;
 }
@@ -203,5 +222,5 @@ void day09_tests()
                         "London to Belfast = 518\n"
                         "Dublin to Belfast = 141";
 
-    printf("Solution: %d\n", day09_solution(input));
+    printf("Solution: %lld\n", day09_solution(input));
 }
@@ -40,21 +40,31 @@ char *day10_get_nth(strv input_sv, size_t n)
     return answer;
 }
 
-int day10_length(const char *input)
+long long day10_length(const char *input)
 {
+    PROF_BEGIN(solve, "day10/solve");
     strv input_sv = strv_trim(strv_from(input));
     char *answer = day10_get_nth(input_sv, 40);
-    int ans = (int)strlen(answer);
+    long long ans = (long long)strlen(answer);
+    PROF_END(solve);
+
+    PROF_BEGIN(teardown, "day10/teardown");
     da_free(answer);
+    PROF_END(teardown);
     return ans;
 }
 
-int day10_length_2(const char *input)
+long long day10_length_2(const char *input)
 {
+    PROF_BEGIN(solve, "day10/solve");
     strv input_sv = strv_trim(strv_from(input));
     char *answer = day10_get_nth(input_sv, 50);
-    int ans = (int)strlen(answer);
+    long long ans = (long long)strlen(answer);
+    PROF_END(solve);
+
+    PROF_BEGIN(teardown, "day10/teardown");
     da_free(answer);
+    PROF_END(teardown);
     return ans;
 }
 
@@ -76,8 +76,9 @@ bool day11_has_straight(strv sv)
     return false;
 }
 
-int day11_next_password(const char *input)
+long long day11_next_password(const char *input)
 {
+    PROF_ZONE("day11/solve");
     strv input_sv = strv_trim(strv_from(input));
     char *next = malloc(input_sv.size + 1);
     strv next_sv = strv_dup(input_sv);
@@ -101,8 +102,9 @@ int day11_next_password(const char *input)
     return 0;
 }
 
-int day11_next_password_2(const char *input)
+long long day11_next_password_2(const char *input)
 {
+    PROF_ZONE("day11/solve");
     strv input_sv = strv_trim(strv_from(input));
     char *next = malloc(input_sv.size + 1);
     strv next_sv = strv_dup(input_sv);
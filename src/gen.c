@@ -0,0 +1,494 @@
+// Synthetic input generator.
+//
+// Writes a valid input for a given day to stdout, in the same format as
+// the files in inputs/. Output is a pure function of the arguments, so
+// a (day, seed, size) triple always names the same input.
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+struct gen_opts {
+    uint64_t seed;
+    size_t count;     // Number of items (characters, lines, wires, cities, ...)
+    uint64_t bytes;   // Stop once at least this many bytes are written
+    size_t grid;      // Day 6 grid side length
+};
+
+struct gen {
+    uint64_t state;
+    uint64_t written;
+    const struct gen_opts *opts;
+};
+
+// splitmix64
+uint64_t gen_next(struct gen *g)
+{
+    uint64_t z = (g->state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Uniform integer in [lo, hi]
+uint64_t gen_range(struct gen *g, uint64_t lo, uint64_t hi)
+{
+    return lo + gen_next(g) % (hi - lo + 1);
+}
+
+void gen_write(struct gen *g, const char *s, size_t size)
+{
+    fwrite(s, 1, size, stdout);
+    g->written += size;
+}
+
+void gen_printf(struct gen *g, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+void gen_printf(struct gen *g, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int n = vprintf(fmt, args);
+    va_end(args);
+
+    if (n > 0) g->written += (uint64_t)n;
+}
+
+// True while more items should be generated
+bool gen_more(const struct gen *g, size_t i)
+{
+    if (g->opts->bytes)
+        return g->written < g->opts->bytes;
+
+    return i < g->opts->count;
+}
+
+// Day 1: a stream of parentheses, no trailing newline. A run of '('
+// lifts the walk off the ground, it drifts up for the first two thirds
+// and down five times as fast after that, so the basement is found
+// around 88% of the way in instead of within the first few bytes.
+void gen_day01(struct gen *g)
+{
+    uint64_t total = g->opts->bytes ? g->opts->bytes : g->opts->count;
+    char buf[4096];
+    size_t len = 0;
+    for (size_t i = 0; gen_more(g, i); i++) {
+        uint64_t up_percent = (uint64_t)i < total / 64 ? 100 : (uint64_t)i < total / 3 * 2 ? 52 : 40;
+        buf[len++] = gen_range(g, 0, 99) < up_percent ? '(' : ')';
+        if (len == sizeof(buf)) {
+            gen_write(g, buf, len);
+            len = 0;
+        }
+    }
+
+    gen_write(g, buf, len);
+}
+
+// Day 2: LxWxH box dimensions, one per line
+void gen_day02(struct gen *g)
+{
+    for (size_t i = 0; gen_more(g, i); i++)
+        gen_printf(g, "%dx%dx%d\n",
+                   (int)gen_range(g, 1, 30), (int)gen_range(g, 1, 30), (int)gen_range(g, 1, 30));
+}
+
+// Day 3: a string of moves, no trailing newline
+void gen_day03(struct gen *g)
+{
+    const char moves[] = "^>v<";
+    char buf[4096];
+    size_t len = 0;
+    for (size_t i = 0; gen_more(g, i); i++) {
+        buf[len++] = moves[gen_next(g) & 3];
+        if (len == sizeof(buf)) {
+            gen_write(g, buf, len);
+            len = 0;
+        }
+    }
+
+    gen_write(g, buf, len);
+}
+
+// Day 4: a secret key of count lowercase letters
+void gen_day04(struct gen *g)
+{
+    size_t n = g->opts->count ? g->opts->count : 8;
+    for (size_t i = 0; i < n; i++)
+        gen_printf(g, "%c", (char)('a' + gen_range(g, 0, 25)));
+    gen_printf(g, "\n");
+}
+
+// Day 5: 16 character lowercase strings, one per line
+void gen_day05(struct gen *g)
+{
+    char line[17];
+    line[16] = '\n';
+    for (size_t i = 0; gen_more(g, i); i++) {
+        for (size_t j = 0; j < 16; j++)
+            line[j] = (char)('a' + gen_range(g, 0, 25));
+        gen_write(g, line, sizeof(line));
+    }
+}
+
+// Day 6: light instructions over a grid x grid area
+void gen_day06(struct gen *g)
+{
+    const char *ops[] = {"turn on", "turn off", "toggle"};
+    uint64_t max = g->opts->grid - 1;
+    for (size_t i = 0; gen_more(g, i); i++) {
+        uint64_t x0 = gen_range(g, 0, max), x1 = gen_range(g, 0, max);
+        uint64_t y0 = gen_range(g, 0, max), y1 = gen_range(g, 0, max);
+        if (x0 > x1) { uint64_t t = x0; x0 = x1; x1 = t; }
+        if (y0 > y1) { uint64_t t = y0; y0 = y1; y1 = t; }
+
+        gen_printf(g, "%s %llu,%llu through %llu,%llu\n", ops[gen_range(g, 0, 2)],
+                   (unsigned long long)x0, (unsigned long long)y0,
+                   (unsigned long long)x1, (unsigned long long)y1);
+    }
+}
+
+// Wire names for day 7. "a" and "b" are reserved, everything else has
+// at least two letters.
+void gen_wire_name(char *buf, size_t i)
+{
+    char tmp[16];
+    size_t len = 0;
+    i += 26;
+    while (i > 0) {
+        tmp[len++] = (char)('a' + i % 26);
+        i /= 26;
+    }
+
+    for (size_t j = 0; j < len; j++)
+        buf[j] = tmp[len - 1 - j];
+    buf[len] = '\0';
+}
+
+enum gen_gate_kind {
+    GEN_COPY,
+    GEN_NOT,
+    GEN_AND,
+    GEN_AND_LITERAL,
+    GEN_OR,
+    GEN_OR_LITERAL,
+    GEN_LSHIFT,
+    GEN_RSHIFT,
+    GEN_GATE_KINDS,
+};
+
+// Day 7 wire k >= 1: a gate on wire k - 1 and wire src or a literal
+struct gen_gate {
+    enum gen_gate_kind kind;
+    size_t src;
+    uint16_t literal; // Also the shift amount
+};
+
+uint16_t gen_gate_eval(const struct gen_gate *gate, uint16_t x, uint16_t y)
+{
+    switch (gate->kind) {
+    case GEN_COPY:        return x;
+    case GEN_NOT:         return (uint16_t)~x;
+    case GEN_AND:         return x & y;
+    case GEN_AND_LITERAL: return x & gate->literal;
+    case GEN_OR:          return x | y;
+    case GEN_OR_LITERAL:  return x | gate->literal;
+    case GEN_LSHIFT:      return (uint16_t)(x << gate->literal);
+    default:              return x >> gate->literal;
+    }
+}
+
+// Signals of wires 0 to n, given the signal on "b"
+void gen_circuit_eval(const struct gen_gate *gates, size_t n, uint16_t b, uint16_t *vals)
+{
+    vals[0] = b;
+    for (size_t k = 1; k <= n; k++)
+        vals[k] = gen_gate_eval(&gates[k], vals[k - 1], vals[gates[k].src]);
+}
+
+// Day 7: an acyclic circuit of count wires, in shuffled order. "b" is
+// set directly by a signal (part 2 overrides it). Every other wire reads
+// the wire before it and maybe one earlier wire or a literal, so "a",
+// driven by the last wire, sits at the end of a chain through all of
+// them. Signals are simulated while generating, and a gate that would
+// turn the chain to all zeros or all ones becomes a NOT. "a" also reads
+// NOT b, so that part 2's override of "b" changes the answer, through
+// whichever of AND and OR keeps both answers away from 0 and 65535.
+void gen_day07(struct gen *g)
+{
+    size_t n = g->opts->count ? g->opts->count : 300;
+    char (*lines)[64] = malloc(sizeof(*lines) * (n + 3));
+    struct gen_gate *gates = malloc(sizeof(*gates) * (n + 1));
+    uint16_t *vals = malloc(sizeof(*vals) * (n + 1));
+    if (!lines || !gates || !vals) {
+        perror("OOM");
+        exit(1);
+    }
+
+    // Wire 0 is "b", wire k >= 1 is gen_wire_name(k - 1)
+    vals[0] = (uint16_t)gen_range(g, 1, 65534);
+    for (size_t k = 1; k <= n; k++) {
+        struct gen_gate *gate = &gates[k];
+        gate->kind = (enum gen_gate_kind)gen_range(g, 0, GEN_GATE_KINDS - 1);
+        gate->src = gen_range(g, 0, k - 1);
+        gate->literal = gate->kind >= GEN_LSHIFT ? (uint16_t)gen_range(g, 1, 15)
+                                                 : (uint16_t)gen_range(g, 1, 65535);
+
+        // vals[k - 1] is neither, so neither is its NOT
+        vals[k] = gen_gate_eval(gate, vals[k - 1], vals[gate->src]);
+        if (vals[k] == 0 || vals[k] == 0xffff) {
+            gate->kind = GEN_NOT;
+            vals[k] = (uint16_t)~vals[k - 1];
+        }
+    }
+
+    // Part 1 gets t op ~b. Part 2 reruns the circuit with that on "b".
+    bool use_and = false;
+    if (n > 0) {
+        uint16_t b = vals[0], t = vals[n];
+        uint16_t and_1 = t & (uint16_t)~b;
+        gen_circuit_eval(gates, n, and_1, vals);
+        uint16_t and_2 = vals[n] & (uint16_t)~and_1;
+        use_and = and_1 != 0 && and_2 != 0 && and_1 != 0xffff && and_2 != 0xffff && and_1 != and_2;
+        vals[0] = b;
+    }
+
+    char name[16], in1[16], in2[16];
+    snprintf(lines[0], sizeof(lines[0]), "%d -> b", vals[0]);
+    for (size_t k = 1; k <= n; k++) {
+        const struct gen_gate *gate = &gates[k];
+        gen_wire_name(name, k - 1);
+        if (k == 1) strcpy(in1, "b"); else gen_wire_name(in1, k - 2);
+        if (gate->src == 0) strcpy(in2, "b"); else gen_wire_name(in2, gate->src - 1);
+
+        switch (gate->kind) {
+        case GEN_COPY:
+            snprintf(lines[k], sizeof(lines[k]), "%s -> %s", in1, name);
+            break;
+        case GEN_NOT:
+            snprintf(lines[k], sizeof(lines[k]), "NOT %s -> %s", in1, name);
+            break;
+        case GEN_AND:
+            snprintf(lines[k], sizeof(lines[k]), "%s AND %s -> %s", in1, in2, name);
+            break;
+        case GEN_AND_LITERAL:
+            snprintf(lines[k], sizeof(lines[k]), "%d AND %s -> %s", gate->literal, in1, name);
+            break;
+        case GEN_OR:
+            snprintf(lines[k], sizeof(lines[k]), "%s OR %s -> %s", in1, in2, name);
+            break;
+        case GEN_OR_LITERAL:
+            snprintf(lines[k], sizeof(lines[k]), "%d OR %s -> %s", gate->literal, in1, name);
+            break;
+        case GEN_LSHIFT:
+            snprintf(lines[k], sizeof(lines[k]), "%s LSHIFT %d -> %s", in1, gate->literal, name);
+            break;
+        default:
+            snprintf(lines[k], sizeof(lines[k]), "%s RSHIFT %d -> %s", in1, gate->literal, name);
+            break;
+        }
+    }
+
+    // Wire n + 1 is NOT b
+    gen_wire_name(in2, n);
+    snprintf(lines[n + 1], sizeof(lines[n + 1]), "NOT b -> %s", in2);
+    if (n == 0) strcpy(in1, "b"); else gen_wire_name(in1, n - 1);
+    snprintf(lines[n + 2], sizeof(lines[n + 2]), "%s %s %s -> a", in1, use_and ? "AND" : "OR", in2);
+
+    // Fisher-Yates
+    for (size_t i = n + 2; i > 0; i--) {
+        size_t j = gen_range(g, 0, i);
+        char tmp[64];
+        memcpy(tmp, lines[i], sizeof(tmp));
+        memcpy(lines[i], lines[j], sizeof(tmp));
+        memcpy(lines[j], tmp, sizeof(tmp));
+    }
+
+    for (size_t i = 0; i < n + 3; i++)
+        gen_printf(g, "%s\n", lines[i]);
+
+    free(vals);
+    free(gates);
+    free(lines);
+}
+
+// Day 8: quoted string literals with \\, \" and \xHH escapes
+void gen_day08(struct gen *g)
+{
+    const char hex[] = "0123456789abcdef";
+    for (size_t i = 0; gen_more(g, i); i++) {
+        char line[256];
+        size_t len = 0;
+        line[len++] = '"';
+
+        size_t n = gen_range(g, 0, 30);
+        for (size_t j = 0; j < n; j++) {
+            switch (gen_range(g, 0, 9)) {
+            case 0:
+                line[len++] = '\\';
+                line[len++] = '\\';
+                break;
+            case 1:
+                line[len++] = '\\';
+                line[len++] = '"';
+                break;
+            case 2:
+                line[len++] = '\\';
+                line[len++] = 'x';
+                line[len++] = hex[gen_range(g, 0, 15)];
+                line[len++] = hex[gen_range(g, 0, 15)];
+                break;
+            default:
+                line[len++] = (char)('a' + gen_range(g, 0, 25));
+                break;
+            }
+        }
+
+        line[len++] = '"';
+        line[len++] = '\n';
+        gen_write(g, line, len);
+    }
+}
+
+// Day 9: distances between every pair of count cities.
+// The solver tries every permutation, so keep count small.
+void gen_day09(struct gen *g)
+{
+    size_t n = g->opts->count ? g->opts->count : 8;
+    const char *syllables[] = {"ar", "bel", "dun", "fa", "lon", "mor", "ner", "os", "tra", "vin", "zel", "ka"};
+
+    char (*names)[32] = malloc(sizeof(*names) * n);
+    if (!names) {
+        perror("OOM");
+        exit(1);
+    }
+
+    // Names are built from the index, so they are unique
+    for (size_t i = 0; i < n; i++) {
+        size_t len = 0;
+        size_t k = i;
+        do {
+            const char *syl = syllables[k % SIZE(syllables)];
+            size_t syl_len = strlen(syl);
+            memcpy(names[i] + len, syl, syl_len);
+            len += syl_len;
+            k /= SIZE(syllables);
+        } while (k > 0 && len < 24);
+        names[i][len] = '\0';
+        names[i][0] = (char)(names[i][0] - 'a' + 'A');
+    }
+
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = i + 1; j < n; j++)
+            gen_printf(g, "%s to %s = %d\n", names[i], names[j], (int)gen_range(g, 10, 150));
+
+    free(names);
+}
+
+// Day 10: a look-and-say seed of digits 1-3 with no run longer than
+// 3, so every later term still has single digit run lengths.
+void gen_day10(struct gen *g)
+{
+    char prev = 0;
+    int run = 0;
+    for (size_t i = 0; gen_more(g, i); i++) {
+        char c;
+        do {
+            c = (char)('1' + gen_range(g, 0, 2));
+        } while (c == prev && run == 3);
+
+        run = c == prev ? run + 1 : 1;
+        prev = c;
+        gen_write(g, &c, 1);
+    }
+
+    gen_write(g, "\n", 1);
+}
+
+// Day 11: a password of count lowercase letters
+void gen_day11(struct gen *g)
+{
+    size_t n = g->opts->count ? g->opts->count : 8;
+    for (size_t i = 0; i < n; i++)
+        gen_printf(g, "%c", (char)('a' + gen_range(g, 0, 25)));
+    gen_printf(g, "\n");
+}
+
+struct gen_day {
+    void (*fn)(struct gen *g);
+    size_t default_count;
+};
+
+struct gen_day gen_days[] = {
+    {gen_day01, 7000},
+    {gen_day02, 1000},
+    {gen_day03, 8192},
+    {gen_day04, 8},
+    {gen_day05, 1000},
+    {gen_day06, 300},
+    {gen_day07, 300},
+    {gen_day08, 300},
+    {gen_day09, 8},
+    {gen_day10, 10},
+    {gen_day11, 8},
+};
+
+void gen_usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-s SEED] [-n COUNT] [-b BYTES] [-g GRID] DAY\n", prog);
+    fprintf(stderr, "  -s SEED   random seed (default 1)\n");
+    fprintf(stderr, "  -n COUNT  number of items: characters, lines, wires, cities, ...\n");
+    fprintf(stderr, "  -b BYTES  keep generating items until at least BYTES are written\n");
+    fprintf(stderr, "            (days 1, 2, 3, 5, 6, 8 and 10)\n");
+    fprintf(stderr, "  -g GRID   day 6 grid side length (default 1000)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    struct gen_opts opts = {
+        .seed = 1,
+        .grid = 1000,
+    };
+
+    int day = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            opts.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            opts.count = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            opts.bytes = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            opts.grid = strtoull(argv[++i], NULL, 10);
+        } else if (day == 0) {
+            day = atoi(argv[i]);
+        } else {
+            gen_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (day < 1 || (size_t)day > SIZE(gen_days) || opts.grid == 0) {
+        gen_usage(argv[0]);
+        return 1;
+    }
+
+    if (opts.count == 0 && opts.bytes == 0)
+        opts.count = gen_days[day - 1].default_count;
+
+    static char buf[1 << 20];
+    setvbuf(stdout, buf, _IOFBF, sizeof(buf));
+
+    // Mix the day into the seed so days don't share a sequence
+    struct gen g = {
+        .state = opts.seed * 0x2545f4914f6cdd1dULL + (uint64_t)day,
+        .opts = &opts,
+    };
+    gen_days[day - 1].fn(&g);
+
+    fflush(stdout);
+    return 0;
+}
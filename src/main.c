@@ -1,9 +1,11 @@
+#include "alloc_stats.h" // Must come first, it may override malloc & co
 #include <stdio.h>
 #include "utils.h"
+#include "prof.h"
 #include "day01.c"
 #include "day02.c"
 #include "day03.c"
-/* #include "day04.c" */
+#include "day04.c"
 #include "day05.c"
 #include "day06.c"
 #include "day07.c"
@@ -11,12 +13,15 @@
 #include "day09.c"
 #include "day10.c"
 #include "day11.c"
+#include "bench.c"
+#include "cache.c"
+#include "stream.c"
 
-int (*solutions[][2])(const char *) = {
+long long (*solutions[][2])(const char *) = {
     {day01_move_to_floor, day01_basement_position},
     {day02_wrapping_paper, day02_ribbon},
     {day03_visit, day03_robo},
-    {NULL, NULL}, // Day 4
+    {day04_mine, day04_mine_2},
     {day05_nice_strings, day05_nice_strings_2},
     {day06_count_lights, day06_count_lights_2},
     {day07_run_instructions, day07_run_instructions_2},
@@ -26,6 +31,340 @@ int (*solutions[][2])(const char *) = {
     {day11_next_password, day11_next_password_2},
 };
 
+// Solvers that can consume their input in chunks
+struct stream_solution stream_solutions[][2] = {
+    {
+        {day01_stream_init, day01_stream_feed, day01_stream_finish},
+        {day01_stream_init_2, day01_stream_feed, day01_stream_finish},
+    },
+    {
+        {day02_stream_init, day02_stream_feed, day02_stream_finish},
+        {day02_stream_init_2, day02_stream_feed, day02_stream_finish},
+    },
+    {{0}, {0}}, // Day 3
+    {{0}, {0}}, // Day 4
+    {
+        {day05_stream_init, day05_stream_feed, day05_stream_finish},
+        {day05_stream_init_2, day05_stream_feed, day05_stream_finish},
+    },
+    {
+        {day06_stream_init, day06_stream_feed, day06_stream_finish},
+        {day06_stream_init_2, day06_stream_feed, day06_stream_finish},
+    },
+    {{0}, {0}}, // Day 7
+    {
+        {day08_stream_init, day08_stream_feed, day08_stream_finish},
+        {day08_stream_init_2, day08_stream_feed, day08_stream_finish},
+    },
+};
+
+#include "run_all.c"
+#include "suite.c"
+#include "server.c"
+#include "microbench.c"
+
+void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [--cache FILE] [--trace FILE] [LOAD OPTIONS] DAY PART [FILE|-]\n", prog);
+    fprintf(stderr, "       %s bench [-n ITERS] [-w WARMUP] [--json|--csv] [LOAD OPTIONS] DAY PART [FILE|-]\n", prog);
+    fprintf(stderr, "       %s suite [--baseline FILE] [--threshold PCT] [--budget-ms MS] [--update] DIR\n", prog);
+    fprintf(stderr, "       %s microbench [--budget-ms MS] [NAME...]\n", prog);
+    fprintf(stderr, "       %s stream [-c CHUNK_BYTES] DAY PART [FILE|-]\n", prog);
+    fprintf(stderr, "       %s all [-j THREADS] [--cache FILE] [--trace FILE]\n", prog);
+    fprintf(stderr, "       %s serve [-j THREADS] [--isolate] SOCKET\n", prog);
+    fprintf(stderr, "       %s client SOCKET DAY PART [FILE]\n", prog);
+    fprintf(stderr, "       %s latency [-n ITERS] SOCKET DAY PART\n", prog);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Load options:\n");
+    fprintf(stderr, "  --no-mmap    read the input into a heap buffer instead of mapping it\n");
+    fprintf(stderr, "  --populate   prefault the whole mapping (MAP_POPULATE)\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Builds with -DALLOC_STATS (make stats) print allocation counts to stderr.\n");
+    fprintf(stderr, "Builds with -DPROF (make prof) print a per-zone timing summary to stderr,\n");
+    fprintf(stderr, "and --trace writes the zones as Chrome trace-event JSON.\n");
+}
+
+// Print the profiler summary and write the trace, if one was asked for.
+// Does nothing in builds without -DPROF.
+bool report_prof(const char *trace_path)
+{
+#ifdef PROF
+    fprintf(stderr, "\n");
+    prof_print_summary(stderr);
+#endif
+
+    if (trace_path && !prof_write_trace(trace_path))
+        return false;
+
+    return true;
+}
+
+// Parse a load option into flags. Return false if arg is not one.
+bool parse_load_flag(const char *arg, int *flags)
+{
+    if (strcmp(arg, "--no-mmap") == 0)
+        *flags |= LOAD_NO_MMAP;
+    else if (strcmp(arg, "--populate") == 0)
+        *flags |= LOAD_POPULATE;
+    else
+        return false;
+
+    return true;
+}
+
+// Parse and validate DAY and PART arguments.
+// Returns the solution function, or NULL after printing an error.
+long long (*parse_solution(const char *day_arg, const char *part_arg, int *day, int *part))(const char *)
+{
+    *day = atoi(day_arg);
+    *part = atoi(part_arg);
+
+    if (*day < 1 || (size_t)*day > SIZE(solutions)) {
+        fprintf(stderr, "Highest day is %zu!\n", SIZE(solutions));
+        return NULL;
+    }
+
+    if (*part < 1 || *part > 2) {
+        fprintf(stderr, "Each solution only has 2 parts\n");
+        return NULL;
+    }
+
+    long long (*f)(const char *) = solutions[*day - 1][*part - 1];
+    if (!f)
+        fprintf(stderr, "Day %d has no solution\n", *day);
+
+    return f;
+}
+
+int run_bench(int argc, char *argv[])
+{
+    struct bench_opts opts = {
+        .iters = 100,
+        .warmup = 5,
+        .format = BENCH_TEXT,
+    };
+
+    int load_flags = LOAD_DEFAULT;
+    const char *args[3] = {0};
+    size_t n_args = 0;
+    for (int i = 2; i < argc; i++) {
+        if (parse_load_flag(argv[i], &load_flags)) {
+            continue;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            opts.iters = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            opts.warmup = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--json") == 0) {
+            opts.format = BENCH_JSON;
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            opts.format = BENCH_CSV;
+        } else if (n_args < SIZE(args)) {
+            args[n_args++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (n_args < 2 || opts.iters == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    struct bench_result res = {0};
+    long long (*f)(const char *) = parse_solution(args[0], args[1], &res.day, &res.part);
+    if (!f) return 1;
+
+    char fname[512];
+    if (args[2])
+        snprintf(fname, sizeof(fname), "%s", args[2]);
+    else
+        input_path(fname, sizeof(fname), res.day);
+
+    struct input_file in;
+    uint64_t start = now_ns();
+    bool loaded = load_input(&in, fname, load_flags);
+    res.load_ns = now_ns() - start;
+    if (!loaded) {
+        fprintf(stderr, "Failed to read input file.\n");
+        return 1;
+    }
+
+    res.input_size = in.size;
+    bool ok = bench_run(f, in.data, &opts, &res);
+    unload_input(&in);
+    if (!ok) return 1;
+
+    if (opts.format == BENCH_CSV)
+        bench_print_csv_header(stdout);
+    bench_print(stdout, &res, opts.format);
+    return 0;
+}
+
+int run_suite_cmd(int argc, char *argv[])
+{
+    struct suite_opts opts = {
+        .baseline = "bench-baseline.csv",
+        .threshold = 10,
+        .budget_ns = 1000000000ULL,
+    };
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            opts.baseline = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            opts.threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--budget-ms") == 0 && i + 1 < argc) {
+            opts.budget_ns = strtoull(argv[++i], NULL, 10) * 1000000ULL;
+        } else if (strcmp(argv[i], "--update") == 0) {
+            opts.update = true;
+        } else if (!opts.dir) {
+            opts.dir = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!opts.dir) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    return run_suite(&opts);
+}
+
+int run_microbench_cmd(int argc, char *argv[])
+{
+    uint64_t budget_ns = 500000000ULL;
+    const char **names = calloc((size_t)argc, sizeof(*names));
+    if (!names) {
+        perror("OOM");
+        return 1;
+    }
+
+    size_t n_names = 0;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--budget-ms") == 0 && i + 1 < argc)
+            budget_ns = strtoull(argv[++i], NULL, 10) * 1000000ULL;
+        else
+            names[n_names++] = argv[i];
+    }
+
+    int ret = run_microbench(names, n_names, budget_ns);
+    free(names);
+    return ret;
+}
+
+int run_streaming(int argc, char *argv[])
+{
+    size_t chunk_size = 64 * 1024;
+    const char *args[3] = {0};
+    size_t n_args = 0;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            chunk_size = strtoul(argv[++i], NULL, 10);
+        } else if (n_args < SIZE(args)) {
+            args[n_args++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (n_args < 2 || chunk_size == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int day, part;
+    if (!parse_solution(args[0], args[1], &day, &part)) return 1;
+
+    if ((size_t)day > SIZE(stream_solutions) || !stream_solutions[day - 1][part - 1].init) {
+        fprintf(stderr, "Day %d has no streaming solution\n", day);
+        return 1;
+    }
+
+    char fname[512];
+    if (args[2])
+        snprintf(fname, sizeof(fname), "%s", args[2]);
+    else
+        input_path(fname, sizeof(fname), day);
+
+    return run_stream(&stream_solutions[day - 1][part - 1], fname, chunk_size);
+}
+
+int run_single(int argc, char *argv[])
+{
+    const char *cache_path = NULL;
+    const char *trace_path = NULL;
+    int load_flags = LOAD_DEFAULT;
+    const char *args[3] = {0};
+    size_t n_args = 0;
+    for (int i = 1; i < argc; i++) {
+        if (parse_load_flag(argv[i], &load_flags)) {
+            continue;
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache_path = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (n_args < SIZE(args)) {
+            args[n_args++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (n_args < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int day, part;
+    long long (*f)(const char *) = parse_solution(args[0], args[1], &day, &part);
+    if (!f) return 1;
+
+    char fname[512];
+    if (args[2])
+        snprintf(fname, sizeof(fname), "%s", args[2]);
+    else
+        input_path(fname, sizeof(fname), day);
+
+    struct input_file in;
+    if (!load_input(&in, fname, load_flags)) {
+        fprintf(stderr, "Failed to read input file.\n");
+        return 1;
+    }
+
+    if (cache_path) {
+        struct cache cache;
+        if (!cache_open(&cache, cache_path)) {
+            unload_input(&in);
+            return 1;
+        }
+
+        long long ans = cache_solve(&cache, day, part, f, in.data);
+        printf("Solution: %lld\n", ans);
+        cache_print_stats(stderr, &cache);
+        cache_close(&cache);
+    } else {
+        struct alloc_stats stats = {0};
+        struct alloc_stats *prev = alloc_stats_begin(&stats);
+        long long ans = f(in.data);
+        alloc_stats_end(prev);
+        printf("Solution: %lld\n", ans);
+
+#ifdef ALLOC_STATS
+        fprintf(stderr, "\nAllocations in day %d part %d:\n", day, part);
+        alloc_stats_print(stderr, &stats);
+#endif
+    }
+
+    unload_input(&in);
+    return report_prof(trace_path) ? 0 : 1;
+}
+
 int main(int argc, char *argv[])
 {
 #ifdef TEST
@@ -34,7 +373,7 @@ int main(int argc, char *argv[])
     day01_tests();
     day02_tests();
     day03_tests();
-    /* day04_tests(); */
+    day04_tests();
     day05_tests();
     day06_tests();
     day07_tests();
@@ -43,38 +382,118 @@ int main(int argc, char *argv[])
     day10_tests();
     day11_tests();
 #else
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s DAY PART\n", argv[0]);
-        return 1;
-    }
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0)
+        return run_bench(argc, argv);
 
-    int day = atoi(argv[1]);
-    int part = atoi(argv[2]);
+    if (argc >= 2 && strcmp(argv[1], "suite") == 0)
+        return run_suite_cmd(argc, argv);
 
-    if (day < 1 || (size_t)day > SIZE(solutions)) {
-        fprintf(stderr, "Highest day is %zu!\n", SIZE(solutions));
-        return 1;
+    if (argc >= 2 && strcmp(argv[1], "microbench") == 0)
+        return run_microbench_cmd(argc, argv);
+
+    if (argc >= 2 && strcmp(argv[1], "stream") == 0)
+        return run_streaming(argc, argv);
+
+    if (argc >= 2 && strcmp(argv[1], "all") == 0) {
+        size_t n_threads = pool_default_threads();
+        const char *cache_path = NULL;
+        const char *trace_path = NULL;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+                n_threads = strtoul(argv[++i], NULL, 10);
+            } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+                cache_path = argv[++i];
+            } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+                trace_path = argv[++i];
+            } else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        if (n_threads == 0) {
+            usage(argv[0]);
+            return 1;
+        }
+
+        struct cache cache;
+        if (cache_path && !cache_open(&cache, cache_path))
+            return 1;
+
+        int ret = run_all(n_threads, cache_path ? &cache : NULL);
+        if (cache_path) {
+            cache_print_stats(stderr, &cache);
+            cache_close(&cache);
+        }
+
+        if (!report_prof(trace_path))
+            return 1;
+
+        return ret;
     }
 
-    if (part < 1 || part > 2) {
-        fprintf(stderr, "Each solution only has 2 parts\n");
-        return 1;
+    if (argc >= 2 && strcmp(argv[1], "serve") == 0) {
+        size_t n_threads = pool_default_threads();
+        bool isolate = false;
+        int i = 2;
+        for (; i < argc - 1; i++) {
+            if (strcmp(argv[i], "-j") == 0 && i + 1 < argc - 1) {
+                n_threads = strtoul(argv[++i], NULL, 10);
+            } else if (strcmp(argv[i], "--isolate") == 0) {
+                isolate = true;
+            } else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        if (i != argc - 1 || n_threads == 0) {
+            usage(argv[0]);
+            return 1;
+        }
+
+        return run_server(argv[argc - 1], n_threads, isolate);
     }
 
-    char fname[512];
-    snprintf(fname, sizeof(fname), "./inputs/day%02d.txt", day);
+    if (argc >= 2 && strcmp(argv[1], "client") == 0) {
+        if (argc != 5 && argc != 6) {
+            usage(argv[0]);
+            return 1;
+        }
 
-    char *input = read_whole_file(fname);
-    if (!input) {
-        fprintf(stderr, "Failed to read input file.\n");
-        return 1;
+        int day, part;
+        if (!parse_solution(argv[3], argv[4], &day, &part)) return 1;
+
+        char fname[512];
+        if (argc == 6)
+            snprintf(fname, sizeof(fname), "%s", argv[5]);
+        else
+            input_path(fname, sizeof(fname), day);
+
+        return run_client(argv[2], day, part, fname);
     }
 
-    int (*f)(const char *) = solutions[day - 1][part - 1];
-    int ans = f(input);
-    printf("Solution: %d\n", ans);
+    if (argc >= 2 && strcmp(argv[1], "latency") == 0) {
+        size_t iters = 100;
+        int first = 2;
+        if (argc == 7 && strcmp(argv[2], "-n") == 0) {
+            iters = strtoul(argv[3], NULL, 10);
+            first = 4;
+        } else if (argc != 5) {
+            usage(argv[0]);
+            return 1;
+        }
+
+        int day, part;
+        if (iters == 0 || !parse_solution(argv[first + 1], argv[first + 2], &day, &part)) {
+            usage(argv[0]);
+            return 1;
+        }
+
+        return run_latency(argv[first], day, part, iters);
+    }
 
-    free(input);
+    return run_single(argc, argv);
 #endif
 
     return 0;
@@ -0,0 +1,439 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+#include "md5.h"
+#include "zset.h"
+
+typedef struct {
+    int x;
+    int y;
+} vec2;
+
+// The generic hash set, as the baseline for zset in microbench_sets
+#define RAX_HSET_TYPE vec2
+#define RAX_HSET_NAME hsetv2
+#define RAX_HSET_EQUAL(X, Y) (X.x == Y.x && X.y == Y.y)
+#include "rax_hset.h"
+
+// Microbenchmarks for the kernels behind the solvers, as opposed to
+// whole solutions (see bench.c). Each one compares the variants of a
+// kernel on synthetic data for about budget_ns each.
+
+struct microbench {
+    const char *name;
+    const char *description;
+    void (*run)(uint64_t budget_ns);
+};
+
+// Keeps results alive so the compiler can't drop the work
+static volatile uint32_t microbench_sink;
+
+void microbench_md5(uint64_t budget_ns)
+{
+    printf("%-8s %6s %14s %14s\n", "kernel", "lanes", "Mhash/s", "Mhash/s/lane");
+
+    for (size_t k = 0; k < SIZE(md5_kernels); k++) {
+        const struct md5_kernel *kernel = &md5_kernels[k];
+        if (!kernel->supported()) {
+            printf("%-8s %6zu %14s\n", kernel->name, kernel->lanes, "unsupported");
+            continue;
+        }
+
+        // Single block day 4 style messages, one per lane
+        uint32_t m[16 * MD5_MAX_LANES];
+        uint32_t out[4 * MD5_MAX_LANES];
+        uint32_t words[16];
+        unsigned char block[MD5_BLOCK_SIZE];
+        for (size_t l = 0; l < kernel->lanes; l++) {
+            int n = snprintf((char *)block, sizeof(block), "abcdefgh%zu", 1000000 + l);
+            md5_pad_block(block, (size_t)n);
+            md5_load_block(words, block);
+            for (size_t w = 0; w < 16; w++)
+                m[w * kernel->lanes + l] = words[w];
+        }
+
+        size_t calls = 0;
+        uint64_t start = now_ns();
+        uint64_t elapsed;
+        do {
+            for (size_t i = 0; i < 1024; i++) {
+                kernel->compress(out, md5_init_state, m);
+                m[0] ^= out[0]; // Make every call depend on the last
+            }
+            calls += 1024;
+            elapsed = now_ns() - start;
+        } while (elapsed < budget_ns);
+        microbench_sink = out[0];
+
+        double rate = (double)(calls * kernel->lanes) / ((double)elapsed / 1e9) / 1e6;
+        printf("%-8s %6zu %14.2f %14.2f\n", kernel->name, kernel->lanes,
+               rate, rate / (double)kernel->lanes);
+    }
+}
+
+#ifndef MICROBENCH_DAY01_BYTES
+#define MICROBENCH_DAY01_BYTES (1ULL << 30)
+#endif
+
+// A long random stream of parens, NUL terminated like a loaded input
+char *microbench_parens(size_t size)
+{
+    char *buf = malloc(size + 1);
+    if (!buf) {
+        perror("OOM");
+        return NULL;
+    }
+
+    uint64_t x = 2015;
+    for (size_t i = 0; i < size; i++) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        buf[i] = (x >> 63) ? '(' : ')';
+    }
+    buf[size] = '\0';
+    return buf;
+}
+
+void microbench_day01(uint64_t budget_ns)
+{
+    size_t size = MICROBENCH_DAY01_BYTES;
+    char *buf = microbench_parens(size);
+    if (!buf) return;
+
+    printf("%-8s %10s %10s\n", "kernel", "passes", "GB/s");
+    for (size_t k = 0; k <= SIZE(day01_kernels); k++) {
+        // The extra round is the whole solver, strlen included
+        bool solver = k == SIZE(day01_kernels);
+        const char *name = solver ? "solver" : day01_kernels[k].name;
+        if (!solver && !day01_kernels[k].supported()) {
+            printf("%-8s %10s\n", name, "unsupported");
+            continue;
+        }
+
+        size_t passes = 0;
+        uint64_t start = now_ns();
+        uint64_t elapsed;
+        do {
+            long long floor;
+            if (solver)
+                floor = day01_move_to_floor(buf);
+            else
+                day01_kernels[k].count(buf, size, &floor);
+            microbench_sink = (uint32_t)floor;
+            passes++;
+            elapsed = now_ns() - start;
+        } while (elapsed < budget_ns);
+
+        printf("%-8s %10zu %10.2f\n", name, passes, (double)(passes * size) / (double)elapsed);
+    }
+
+    // Part 2 chunk summaries (net delta and lowest floor)
+    struct {
+        const char *name;
+        void (*summarize)(const char *, size_t, struct day01_summary *);
+        bool (*supported)(void);
+    } summaries[] = {
+#ifdef DAY01_X86
+        {"sum-avx2", day01_summarize_avx2, day01_avx2_supported},
+        {"sum-sse2", day01_summarize_sse2, day01_sse2_supported},
+#endif
+        {"sum-scal", day01_summarize_scalar, day01_always_supported},
+    };
+    for (size_t k = 0; k < SIZE(summaries); k++) {
+        if (!summaries[k].supported()) {
+            printf("%-8s %10s\n", summaries[k].name, "unsupported");
+            continue;
+        }
+
+        size_t passes = 0;
+        uint64_t start = now_ns();
+        uint64_t elapsed;
+        do {
+            struct day01_summary sum;
+            summaries[k].summarize(buf, size, &sum);
+            microbench_sink = (uint32_t)(sum.delta ^ sum.min);
+            passes++;
+            elapsed = now_ns() - start;
+        } while (elapsed < budget_ns);
+
+        printf("%-8s %10zu %10.2f\n", summaries[k].name, passes, (double)(passes * size) / (double)elapsed);
+    }
+
+    free(buf);
+}
+
+#ifndef MICROBENCH_DAY03_STEPS
+#define MICROBENCH_DAY03_STEPS (16 * 1024 * 1024)
+#endif
+
+// Day 3 houses with K walkers on T threads, in Msteps/s
+void microbench_day03(uint64_t budget_ns)
+{
+    size_t size = MICROBENCH_DAY03_STEPS;
+    char *walk = malloc(size + 1);
+    if (!walk) {
+        perror("OOM");
+        return;
+    }
+
+    uint64_t x = 2015;
+    for (size_t i = 0; i < size; i++) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        walk[i] = "^>v<"[x >> 62];
+    }
+    walk[size] = '\0';
+
+    size_t threads[] = {1, 2, 4, 8};
+    size_t walkers[] = {1, 2, 4, 8};
+    printf("%-8s", "walkers");
+    for (size_t t = 0; t < SIZE(threads); t++)
+        printf(" %8zu thr", threads[t]);
+    printf("\n");
+
+    for (size_t k = 0; k < SIZE(walkers); k++) {
+        printf("%-8zu", walkers[k]);
+        for (size_t t = 0; t < SIZE(threads); t++) {
+            // Split the budget over the grid
+            uint64_t cell_budget = budget_ns / SIZE(threads);
+            size_t passes = 0;
+            uint64_t start = now_ns();
+            uint64_t elapsed;
+            do {
+                microbench_sink = (uint32_t)day03_count_houses_parallel(walk, walkers[k], threads[t]);
+                passes++;
+                elapsed = now_ns() - start;
+            } while (elapsed < cell_budget);
+
+            printf(" %12.1f", (double)(passes * size) / ((double)elapsed / 1e3));
+        }
+        printf("\n");
+    }
+
+    free(walk);
+}
+
+#ifndef MICROBENCH_SETS_STEPS
+#define MICROBENCH_SETS_STEPS 100000000
+#endif
+
+// A walk that calls visit(ctx, x, y) for every house, start included
+enum microbench_walk { WALK_RANDOM, WALK_SPIRAL };
+
+struct microbench_sets {
+    hsetv2 hset;
+    struct zset zset;
+    bool use_zset;
+};
+
+bool microbench_sets_add(struct microbench_sets *m, int x, int y)
+{
+    if (m->use_zset)
+        return zset_add(&m->zset, x, y);
+    return hsetv2_set(&m->hset, (vec2) {.x = x, .y = y}) != NULL;
+}
+
+bool microbench_sets_walk(struct microbench_sets *m, enum microbench_walk walk, size_t steps)
+{
+    int x = 0, y = 0;
+    if (!microbench_sets_add(m, x, y)) return false;
+
+    if (walk == WALK_RANDOM) {
+        uint64_t r = 2015;
+        for (size_t i = 0; i < steps; i++) {
+            r = r * 6364136223846793005ULL + 1442695040888963407ULL;
+            switch (r >> 62) {
+            case 0: y++; break;
+            case 1: x++; break;
+            case 2: y--; break;
+            case 3: x--; break;
+            }
+            if (!microbench_sets_add(m, x, y)) return false;
+        }
+        return true;
+    }
+
+    // Square spiral out from the origin, every house new
+    static const int dx[] = {1, 0, -1, 0};
+    static const int dy[] = {0, 1, 0, -1};
+    size_t i = 0;
+    for (size_t arm = 1; i < steps; arm++) {
+        for (size_t turn = 0; turn < 2 && i < steps; turn++) {
+            size_t dir = (2 * (arm - 1) + turn) % 4;
+            for (size_t k = 0; k < arm && i < steps; k++, i++) {
+                x += dx[dir];
+                y += dy[dir];
+                if (!microbench_sets_add(m, x, y)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+// hsetv2 against zset on day 3 style walks
+void microbench_sets(uint64_t budget_ns)
+{
+    const char *walk_names[] = {"random", "spiral"};
+    printf("%-8s %-8s %12s %12s %12s\n", "walk", "set", "houses", "Msteps/s", "table MB");
+    for (int walk = WALK_RANDOM; walk <= WALK_SPIRAL; walk++) {
+        for (int use_zset = 0; use_zset <= 1; use_zset++) {
+            size_t passes = 0;
+            size_t houses = 0;
+            size_t table_bytes = 0;
+            uint64_t start = now_ns();
+            uint64_t elapsed;
+            do {
+                struct microbench_sets m = {.use_zset = use_zset};
+                if (!microbench_sets_walk(&m, walk, MICROBENCH_SETS_STEPS)) {
+                    printf("%-8s %-8s %12s\n", walk_names[walk], use_zset ? "zset" : "hsetv2", "OOM");
+                    hsetv2_destroy(&m.hset);
+                    zset_destroy(&m.zset);
+                    break;
+                }
+
+                houses = use_zset ? m.zset.size : m.hset.size;
+                table_bytes = use_zset
+                    ? m.zset.capacity * sizeof(uint64_t) + m.zset.capacity / 8
+                    : m.hset.capacity * sizeof(*m.hset.entries);
+                hsetv2_destroy(&m.hset);
+                zset_destroy(&m.zset);
+                passes++;
+                elapsed = now_ns() - start;
+            } while (elapsed < budget_ns);
+            if (!passes) continue;
+
+            printf("%-8s %-8s %12zu %12.1f %12.1f\n", walk_names[walk], use_zset ? "zset" : "hsetv2",
+                   houses, (double)(passes * MICROBENCH_SETS_STEPS) / ((double)elapsed / 1e3),
+                   (double)table_bytes / 1e6);
+        }
+    }
+}
+
+#ifndef MICROBENCH_DAY05_LINES
+#define MICROBENCH_DAY05_LINES (4 * 1024 * 1024)
+#endif
+
+// Random 16 letter lines like the puzzle's, NUL terminated
+char *microbench_day05_text(size_t n_lines, size_t *size)
+{
+    *size = n_lines * 17;
+    char *text = malloc(*size + 1);
+    if (!text) {
+        perror("OOM");
+        return NULL;
+    }
+
+    uint64_t x = 2015;
+    for (size_t i = 0; i < *size; i++) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        text[i] = i % 17 == 16 ? '\n' : (char)('a' + (x >> 32) % 26);
+    }
+    text[*size] = '\0';
+    return text;
+}
+
+void microbench_day05(uint64_t budget_ns)
+{
+    size_t size;
+    char *text = microbench_day05_text(MICROBENCH_DAY05_LINES, &size);
+    if (!text) return;
+
+    printf("%-8s %10s %10s %12s\n", "kernel", "passes", "GB/s", "Mlines/s");
+    for (size_t k = 0; k < SIZE(day05_kernels); k++) {
+        if (!day05_kernels[k].supported()) {
+            printf("%-8s %10s\n", day05_kernels[k].name, "unsupported");
+            continue;
+        }
+
+        size_t passes = 0;
+        uint64_t start = now_ns();
+        uint64_t elapsed;
+        do {
+            microbench_sink = (uint32_t)day05_kernels[k].count(text, size);
+            passes++;
+            elapsed = now_ns() - start;
+        } while (elapsed < budget_ns);
+
+        printf("%-8s %10zu %10.2f %12.1f\n", day05_kernels[k].name, passes,
+               (double)(passes * size) / (double)elapsed,
+               (double)(passes * MICROBENCH_DAY05_LINES) / ((double)elapsed / 1e3));
+    }
+
+    free(text);
+}
+
+#ifndef MICROBENCH_DAY05_PARALLEL_LINES
+#define MICROBENCH_DAY05_PARALLEL_LINES (128 * 1024 * 1024) // 2.1 GB
+#endif
+
+// Both day 5 parts in one pass, by thread count
+void microbench_day05_parallel(uint64_t budget_ns)
+{
+    size_t size;
+    char *text = microbench_day05_text(MICROBENCH_DAY05_PARALLEL_LINES, &size);
+    if (!text) return;
+
+    size_t max_threads = 2 * pool_default_threads();
+    if (max_threads < 8) max_threads = 8;
+
+    printf("%-8s %10s %10s %10s\n", "threads", "passes", "GB/s", "speedup");
+    double base = 0;
+    for (size_t n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+        size_t passes = 0;
+        uint64_t start = now_ns();
+        uint64_t elapsed;
+        do {
+            struct day05_counts counts;
+            if (!day05_count_parallel(text, size, n_threads, DAY05_BLOCK, DAY05_BOTH_PARTS, &counts)) break;
+            microbench_sink = (uint32_t)(counts.nice ^ counts.nice_2);
+            passes++;
+            elapsed = now_ns() - start;
+        } while (elapsed < budget_ns);
+        if (!passes) continue;
+
+        double rate = (double)(passes * size) / (double)elapsed;
+        if (n_threads == 1) base = rate;
+        printf("%-8zu %10zu %10.2f %10.2f\n", n_threads, passes, rate, rate / base);
+    }
+
+    free(text);
+}
+
+struct microbench microbenches[] = {
+    {"md5", "day 4 MD5 compression, per lane width", microbench_md5},
+    {"day01", "day 1 paren counting and summaries over a 1 GiB stream", microbench_day01},
+    {"day03", "day 3 houses in Msteps/s, by walkers and threads", microbench_day03},
+    {"sets", "hsetv2 against zset on 100M step day 3 walks", microbench_sets},
+    {"day05", "day 5 part 1 classifiers over 4M lines", microbench_day05},
+    {"day05-parallel", "day 5 both parts over 2.1 GB, by threads", microbench_day05_parallel},
+};
+
+int run_microbench(const char **names, size_t n_names, uint64_t budget_ns)
+{
+    for (size_t i = 0; i < n_names; i++) {
+        bool found = false;
+        for (size_t j = 0; j < SIZE(microbenches); j++)
+            if (strcmp(names[i], microbenches[j].name) == 0)
+                found = true;
+
+        if (!found) {
+            fprintf(stderr, "Unknown microbenchmark: %s\n", names[i]);
+            return 1;
+        }
+    }
+
+    bool first = true;
+    for (size_t j = 0; j < SIZE(microbenches); j++) {
+        bool selected = n_names == 0;
+        for (size_t i = 0; i < n_names; i++)
+            if (strcmp(names[i], microbenches[j].name) == 0)
+                selected = true;
+        if (!selected) continue;
+
+        printf("%s%s: %s\n", first ? "" : "\n", microbenches[j].name, microbenches[j].description);
+        microbenches[j].run(budget_ns);
+        first = false;
+    }
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+#include "pool.h"
+
+// Run-all mode: load every input once, then solve every non-NULL
+// entry of the solutions table on a worker pool.
+
+struct all_task {
+    int day;
+    int part;
+    long long (*f)(const char *);
+    const char *input;
+    struct cache *cache;
+
+    struct alloc_stats alloc;
+    long long answer;
+    uint64_t start_ns;
+    uint64_t end_ns;
+};
+
+void all_task_run(void *arg)
+{
+    struct all_task *task = arg;
+    struct alloc_stats *prev = alloc_stats_begin(&task->alloc);
+    task->start_ns = now_ns();
+    if (task->cache)
+        task->answer = cache_solve(task->cache, task->day, task->part, task->f, task->input);
+    else
+        task->answer = task->f(task->input);
+    task->end_ns = now_ns();
+    alloc_stats_end(prev);
+}
+
+int run_all(size_t n_threads, struct cache *cache)
+{
+    struct input_file inputs[SIZE(solutions)] = {0};
+    struct all_task tasks[SIZE(solutions) * 2];
+    size_t n_tasks = 0;
+
+    uint64_t load_start = now_ns();
+    for (size_t day = 1; day <= SIZE(solutions); day++) {
+        if (!solutions[day - 1][0] && !solutions[day - 1][1])
+            continue;
+
+        char fname[512];
+        input_path(fname, sizeof(fname), (int)day);
+        if (!load_input(&inputs[day - 1], fname, LOAD_DEFAULT)) {
+            fprintf(stderr, "Skipping day %zu: failed to read %s\n", day, fname);
+            continue;
+        }
+
+        for (int part = 1; part <= 2; part++) {
+            if (!solutions[day - 1][part - 1]) continue;
+
+            tasks[n_tasks++] = (struct all_task) {
+                .day = (int)day,
+                .part = part,
+                .f = solutions[day - 1][part - 1],
+                .input = inputs[day - 1].data,
+                .cache = cache,
+            };
+        }
+    }
+    uint64_t load_ns = now_ns() - load_start;
+
+    struct pool pool;
+    if (!pool_init(&pool, n_threads, 0))
+        return 1;
+
+    // Solvers that print their own answers would interleave with
+    // each other, so only the summary below goes to stdout.
+    int saved = bench_silence_stdout();
+    uint64_t run_start = now_ns();
+    for (size_t i = 0; i < n_tasks; i++)
+        pool_submit(&pool, all_task_run, &tasks[i]);
+    pool_wait(&pool);
+    uint64_t run_end = now_ns();
+    bench_restore_stdout(saved);
+
+    size_t workers = pool.n_threads;
+    pool_destroy(&pool);
+
+    uint64_t total_ns = 0;
+    uint64_t critical_ns = 0;
+    for (size_t i = 0; i < n_tasks; i++) {
+        const struct all_task *task = &tasks[i];
+        uint64_t ns = task->end_ns - task->start_ns;
+        total_ns += ns;
+        if (ns > critical_ns) critical_ns = ns;
+
+        printf("Day %02d part %d: %-12lld %12.3f ms\n",
+               task->day, task->part, task->answer, (double)ns / 1e6);
+    }
+
+    printf("\n");
+    printf("Tasks:          %zu on %zu threads\n", n_tasks, workers);
+    printf("Load inputs:    %12.3f ms\n", (double)load_ns / 1e6);
+    printf("Sum of tasks:   %12.3f ms\n", (double)total_ns / 1e6);
+    printf("Critical path:  %12.3f ms\n", (double)critical_ns / 1e6);
+    printf("Wall time:      %12.3f ms\n", (double)(run_end - run_start) / 1e6);
+
+#ifdef ALLOC_STATS
+    fprintf(stderr, "\n");
+    alloc_stats_print_header(stderr);
+    for (size_t i = 0; i < n_tasks; i++) {
+        char label[32];
+        snprintf(label, sizeof(label), "day%02d/%d", tasks[i].day, tasks[i].part);
+        alloc_stats_print_line(stderr, label, &tasks[i].alloc);
+    }
+#endif
+
+    for (size_t i = 0; i < SIZE(inputs); i++)
+        unload_input(&inputs[i]);
+
+    return 0;
+}
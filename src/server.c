@@ -0,0 +1,636 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "utils.h"
+#include "pool.h"
+
+// Solver daemon over a Unix domain socket.
+//
+// A connection carries any number of requests. Each request is a
+// header followed by `size` bytes of puzzle input, and is answered with
+// a single response. Both ends are on the same machine, so fields are
+// in host byte order.
+//
+// Solves run in-process on the worker. With --isolate, each solve runs
+// in a forked child instead, so that a solver that asserts or crashes
+// on bad input only takes the child down. That costs a fork per request
+// (hundreds of us) and is only best-effort: the child of a threaded
+// process may run into locks held at fork time. Responses say whether
+// the solve was isolated, so latency reports it.
+//
+// Idle connections wait in the main thread's poll loop. When one has a
+// request, it is handed to a worker for that one request and then comes
+// back to the loop, so idle clients don't hold workers. Connections idle
+// for too long are closed, and socket timeouts bound how long a stalled
+// client can keep a worker mid-request.
+
+#ifndef SERVER_MAX_INPUT
+#define SERVER_MAX_INPUT (1ULL << 32)
+#endif
+
+#ifndef SERVER_IDLE_TIMEOUT_MS
+#define SERVER_IDLE_TIMEOUT_MS 30000
+#endif
+
+#ifndef SERVER_IO_TIMEOUT_MS
+#define SERVER_IO_TIMEOUT_MS 5000
+#endif
+
+enum server_status {
+    SERVER_OK = 0,
+    SERVER_BAD_REQUEST,
+    SERVER_NO_SOLUTION,
+    SERVER_OOM,
+    SERVER_SOLVE_FAILED,
+};
+
+struct server_request {
+    uint32_t day;
+    uint32_t part;
+    uint64_t size;
+};
+
+#define SERVER_FLAG_ISOLATED 1 // Solved in a forked child
+
+struct server_response {
+    int32_t status;
+    int32_t flags;
+    int64_t answer;
+};
+
+static volatile sig_atomic_t server_stop = 0;
+
+void server_on_signal(int sig)
+{
+    (void)sig;
+    server_stop = 1;
+}
+
+// Read exactly size bytes. Return false on EOF or error.
+bool server_read_full(int fd, void *buf, size_t size)
+{
+    unsigned char *p = buf;
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+
+        p += n;
+        size -= (size_t)n;
+    }
+
+    return true;
+}
+
+bool server_write_full(int fd, const void *buf, size_t size)
+{
+    const unsigned char *p = buf;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+
+        p += n;
+        size -= (size_t)n;
+    }
+
+    return true;
+}
+
+// Drain and drop size bytes of a request we are not going to solve.
+bool server_skip(int fd, uint64_t size)
+{
+    char buf[4096];
+    while (size > 0) {
+        size_t chunk = size < sizeof(buf) ? (size_t)size : sizeof(buf);
+        if (!server_read_full(fd, buf, chunk)) return false;
+        size -= chunk;
+    }
+
+    return true;
+}
+
+// Solve in a forked child. Return false if the solve failed.
+bool server_solve_isolated(long long (*f)(const char *), const char *input, long long *answer)
+{
+    int p[2];
+    if (pipe(p) < 0) {
+        perror("pipe failed");
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork failed");
+        close(p[0]);
+        close(p[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        close(p[0]);
+        long long ans = f(input);
+        _exit(server_write_full(p[1], &ans, sizeof(ans)) ? 0 : 1);
+    }
+
+    close(p[1]);
+    bool ok = server_read_full(p[0], answer, sizeof(*answer));
+    close(p[0]);
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return false;
+    }
+
+    return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Serve one request. Return false if the connection should be closed.
+bool server_serve_one(int fd, bool isolate)
+{
+    struct server_request req;
+    if (!server_read_full(fd, &req, sizeof(req)))
+        return false;
+
+    struct server_response resp = {0};
+
+    long long (*f)(const char *) = NULL;
+    if (req.day >= 1 && req.day <= SIZE(solutions) && req.part >= 1 && req.part <= 2)
+        f = solutions[req.day - 1][req.part - 1];
+
+    if (req.size > SERVER_MAX_INPUT) {
+        // Don't try to drain something that big, just hang up.
+        resp.status = SERVER_BAD_REQUEST;
+        server_write_full(fd, &resp, sizeof(resp));
+        return false;
+    }
+
+    char *input = f ? malloc(req.size + 1) : NULL;
+    if (!input) {
+        resp.status = f ? SERVER_OOM : SERVER_NO_SOLUTION;
+        return server_skip(fd, req.size) && server_write_full(fd, &resp, sizeof(resp));
+    }
+
+    if (!server_read_full(fd, input, req.size)) {
+        free(input);
+        return false;
+    }
+    input[req.size] = '\0';
+
+    if (isolate) {
+        resp.flags |= SERVER_FLAG_ISOLATED;
+        long long answer = 0;
+        if (server_solve_isolated(f, input, &answer))
+            resp.answer = answer;
+        else
+            resp.status = SERVER_SOLVE_FAILED;
+    } else {
+        resp.answer = f(input);
+    }
+    free(input);
+
+    return server_write_full(fd, &resp, sizeof(resp));
+}
+
+int server_listen(const char *path)
+{
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path is too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("Failed to create socket");
+        return -1;
+    }
+
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("Failed to bind socket");
+        close(fd);
+        return -1;
+    }
+
+    if (listen(fd, 128) < 0) {
+        perror("Failed to listen on socket");
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int server_connect(const char *path)
+{
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path is too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("Failed to create socket");
+        return -1;
+    }
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("Failed to connect to server");
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+struct server;
+
+struct server_conn {
+    struct server *server;
+    int fd;
+    uint64_t last_active_ns;
+};
+
+struct server {
+    struct pool pool;
+    bool isolate;
+    int wake[2]; // Workers write a byte here when they hand a connection back
+
+    struct server_conn **idle; // Owned by the main thread
+    size_t n_idle;
+    size_t idle_cap;
+
+    pthread_mutex_t lock;
+    struct server_conn **ready; // Handed back by workers, under lock
+    size_t n_ready;
+    size_t ready_cap;
+};
+
+void server_close_conn(struct server_conn *conn)
+{
+    close(conn->fd);
+    free(conn);
+}
+
+// Append conn to a list. Return false if memory allocation fails.
+bool server_list_push(struct server_conn ***list, size_t *size, size_t *cap, struct server_conn *conn)
+{
+    if (*size == *cap) {
+        size_t new_cap = *cap ? *cap * 2 : 16;
+        struct server_conn **new_list = realloc(*list, new_cap * sizeof(*new_list));
+        if (!new_list) {
+            perror("OOM");
+            return false;
+        }
+
+        *list = new_list;
+        *cap = new_cap;
+    }
+
+    (*list)[(*size)++] = conn;
+    return true;
+}
+
+void server_handle_request(void *arg)
+{
+    struct server_conn *conn = arg;
+    struct server *server = conn->server;
+    if (!server_serve_one(conn->fd, server->isolate)) {
+        server_close_conn(conn);
+        return;
+    }
+
+    pthread_mutex_lock(&server->lock);
+    bool queued = server_list_push(&server->ready, &server->n_ready, &server->ready_cap, conn);
+    pthread_mutex_unlock(&server->lock);
+
+    if (!queued) {
+        server_close_conn(conn);
+        return;
+    }
+
+    // The pipe is non-blocking; if it is full the loop is awake anyway
+    char byte = 0;
+    ssize_t n = write(server->wake[1], &byte, 1);
+    (void)n;
+}
+
+// Move connections handed back by workers to the idle list
+void server_collect_ready(struct server *server, uint64_t now)
+{
+    pthread_mutex_lock(&server->lock);
+    for (size_t i = 0; i < server->n_ready; i++) {
+        struct server_conn *conn = server->ready[i];
+        conn->last_active_ns = now;
+        if (!server_list_push(&server->idle, &server->n_idle, &server->idle_cap, conn))
+            server_close_conn(conn);
+    }
+    server->n_ready = 0;
+    pthread_mutex_unlock(&server->lock);
+}
+
+void server_accept(struct server *server, int listen_fd, uint64_t now)
+{
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) {
+        if (errno != EINTR && errno != EAGAIN && errno != ECONNABORTED)
+            perror("accept failed");
+        return;
+    }
+
+    struct timeval timeout = {
+        .tv_sec = SERVER_IO_TIMEOUT_MS / 1000,
+        .tv_usec = (SERVER_IO_TIMEOUT_MS % 1000) * 1000,
+    };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    struct server_conn *conn = malloc(sizeof(*conn));
+    if (!conn) {
+        perror("OOM");
+        close(fd);
+        return;
+    }
+
+    *conn = (struct server_conn) { .server = server, .fd = fd, .last_active_ns = now };
+    if (!server_list_push(&server->idle, &server->n_idle, &server->idle_cap, conn))
+        server_close_conn(conn);
+}
+
+// Hand idle connections with a request to the pool, close the ones
+// idle for too long. pfds holds one entry per idle connection.
+void server_dispatch(struct server *server, const struct pollfd *pfds, uint64_t now)
+{
+    // Backwards, so that swap-removing only moves visited entries
+    for (size_t i = server->n_idle; i-- > 0;) {
+        struct server_conn *conn = server->idle[i];
+        bool has_request = pfds[i].revents != 0;
+        bool timed_out = now - conn->last_active_ns > (uint64_t)SERVER_IDLE_TIMEOUT_MS * 1000000;
+        if (!has_request && !timed_out)
+            continue;
+
+        server->idle[i] = server->idle[--server->n_idle];
+        if (!has_request || !pool_submit(&server->pool, server_handle_request, conn))
+            server_close_conn(conn);
+    }
+}
+
+int run_server(const char *path, size_t n_threads, bool isolate)
+{
+    int listen_fd = server_listen(path);
+    if (listen_fd < 0) return 1;
+
+    // No SA_RESTART, so that poll() is interrupted on shutdown
+    struct sigaction sa = {0};
+    sa.sa_handler = server_on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    struct server server = { .isolate = isolate };
+    if (pipe(server.wake) < 0) {
+        perror("pipe failed");
+        close(listen_fd);
+        return 1;
+    }
+    fcntl(server.wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(server.wake[1], F_SETFL, O_NONBLOCK);
+    pthread_mutex_init(&server.lock, NULL);
+
+    int ret = 1;
+    struct pollfd *pfds = NULL;
+    if (!pool_init(&server.pool, n_threads, 0))
+        goto done;
+
+    fprintf(stderr, "Listening on %s with %zu workers%s\n", path, server.pool.n_threads,
+            isolate ? ", isolating solves" : "");
+    while (!server_stop) {
+        server_collect_ready(&server, now_ns());
+
+        struct pollfd *new_pfds = realloc(pfds, (server.n_idle + 2) * sizeof(*pfds));
+        if (!new_pfds) {
+            perror("OOM");
+            break;
+        }
+        pfds = new_pfds;
+
+        pfds[0] = (struct pollfd) { .fd = listen_fd, .events = POLLIN };
+        pfds[1] = (struct pollfd) { .fd = server.wake[0], .events = POLLIN };
+        for (size_t i = 0; i < server.n_idle; i++)
+            pfds[i + 2] = (struct pollfd) { .fd = server.idle[i]->fd, .events = POLLIN };
+
+        // Wake up now and then to close idle connections
+        if (poll(pfds, server.n_idle + 2, 1000) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll failed");
+            break;
+        }
+
+        if (pfds[1].revents) {
+            char buf[64];
+            while (read(server.wake[0], buf, sizeof(buf)) > 0);
+        }
+
+        uint64_t now = now_ns();
+        server_dispatch(&server, pfds + 2, now);
+        if (pfds[0].revents)
+            server_accept(&server, listen_fd, now);
+    }
+    ret = 0;
+
+    // Idle clients are dropped; requests in flight finish, bounded by
+    // the socket timeouts
+    for (size_t i = 0; i < server.n_idle; i++)
+        server_close_conn(server.idle[i]);
+    server.n_idle = 0;
+    pool_destroy(&server.pool);
+    for (size_t i = 0; i < server.n_ready; i++)
+        server_close_conn(server.ready[i]);
+
+done:
+    close(listen_fd);
+    unlink(path);
+    free(pfds);
+    free(server.idle);
+    free(server.ready);
+    close(server.wake[0]);
+    close(server.wake[1]);
+    pthread_mutex_destroy(&server.lock);
+    return ret;
+}
+
+// Send one request over an open connection.
+// Return false if the connection failed.
+bool server_request(int fd, int day, int part, const char *input, size_t size,
+                    struct server_response *resp)
+{
+    struct server_request req = {
+        .day = (uint32_t)day,
+        .part = (uint32_t)part,
+        .size = size,
+    };
+
+    return server_write_full(fd, &req, sizeof(req))
+        && server_write_full(fd, input, size)
+        && server_read_full(fd, resp, sizeof(*resp));
+}
+
+int run_client(const char *path, int day, int part, const char *fname)
+{
+    struct input_file in;
+    if (!load_input(&in, fname, LOAD_DEFAULT)) {
+        fprintf(stderr, "Failed to read input file.\n");
+        return 1;
+    }
+
+    int fd = server_connect(path);
+    if (fd < 0) {
+        unload_input(&in);
+        return 1;
+    }
+
+    struct server_response resp;
+    bool ok = server_request(fd, day, part, in.data, in.size, &resp);
+    close(fd);
+    unload_input(&in);
+
+    if (!ok) {
+        fprintf(stderr, "Connection to server failed\n");
+        return 1;
+    }
+
+    if (resp.status != SERVER_OK) {
+        fprintf(stderr, "Server returned error %d\n", resp.status);
+        return 1;
+    }
+
+    printf("Solution: %lld\n", (long long)resp.answer);
+    return 0;
+}
+
+// Time a fresh `prog DAY PART` process, from fork until exit.
+// Return 0 on failure.
+uint64_t server_cold_run(const char *prog, int day, int part)
+{
+    char day_arg[16], part_arg[16];
+    snprintf(day_arg, sizeof(day_arg), "%d", day);
+    snprintf(part_arg, sizeof(part_arg), "%d", part);
+
+    fflush(stdout);
+    uint64_t start = now_ns();
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork failed");
+        return 0;
+    }
+
+    if (pid == 0) {
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0) dup2(devnull, STDOUT_FILENO);
+        execl(prog, prog, day_arg, part_arg, (char *)NULL);
+        _exit(127);
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "Cold run of %s failed\n", prog);
+        return 0;
+    }
+
+    return now_ns() - start;
+}
+
+// Compare starting a process per request against asking a running
+// daemon (one connection per request, input sent over the socket), with
+// the bare in-process solve as the floor.
+int run_latency(const char *path, int day, int part, size_t iters)
+{
+    char fname[512];
+    input_path(fname, sizeof(fname), day);
+    struct input_file in;
+    if (!load_input(&in, fname, LOAD_DEFAULT)) {
+        fprintf(stderr, "Failed to read input file.\n");
+        return 1;
+    }
+    const char *input = in.data;
+    size_t size = in.size;
+
+    uint64_t *samples = malloc(sizeof(*samples) * iters);
+    if (!samples) {
+        perror("OOM");
+        unload_input(&in);
+        return 1;
+    }
+
+    struct bench_result cold = { .day = day, .part = part, .input_size = size };
+    struct bench_result warm = { .day = day, .part = part, .input_size = size };
+    struct bench_result solve = { .day = day, .part = part, .input_size = size };
+    bool isolated = false;
+
+    int ret = 1;
+    for (size_t i = 0; i < iters; i++) {
+        samples[i] = server_cold_run("/proc/self/exe", day, part);
+        if (samples[i] == 0) goto done;
+    }
+    bench_summarize(samples, iters, &cold);
+
+    for (size_t i = 0; i < iters; i++) {
+        uint64_t start = now_ns();
+        int fd = server_connect(path);
+        if (fd < 0) goto done;
+
+        struct server_response resp;
+        bool ok = server_request(fd, day, part, input, size, &resp);
+        close(fd);
+        if (!ok || resp.status != SERVER_OK) {
+            fprintf(stderr, "Daemon request failed\n");
+            goto done;
+        }
+
+        samples[i] = now_ns() - start;
+        warm.answer = resp.answer;
+        isolated = resp.flags & SERVER_FLAG_ISOLATED;
+    }
+    bench_summarize(samples, iters, &warm);
+
+    long long (*f)(const char *) = solutions[day - 1][part - 1];
+    for (size_t i = 0; i < iters; i++) {
+        uint64_t start = now_ns();
+        solve.answer = f(input);
+        samples[i] = now_ns() - start;
+    }
+    bench_summarize(samples, iters, &solve);
+
+    printf("Day %02d part %d, %zu requests each\n", day, part, iters);
+    printf("%-8s %12s %12s %12s\n", "", "min (us)", "median (us)", "p99 (us)");
+    printf("%-8s %12.1f %12.1f %12.1f\n", "process",
+           (double)cold.min_ns / 1e3, (double)cold.median_ns / 1e3, (double)cold.p99_ns / 1e3);
+    printf("%-8s %12.1f %12.1f %12.1f%s\n", "daemon",
+           (double)warm.min_ns / 1e3, (double)warm.median_ns / 1e3, (double)warm.p99_ns / 1e3,
+           isolated ? "  (isolated, one fork per request)" : "");
+    printf("%-8s %12.1f %12.1f %12.1f\n", "solve",
+           (double)solve.min_ns / 1e3, (double)solve.median_ns / 1e3, (double)solve.p99_ns / 1e3);
+    ret = 0;
+
+done:
+    free(samples);
+    unload_input(&in);
+    return ret;
+}
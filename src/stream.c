@@ -0,0 +1,90 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "utils.h"
+
+// Streaming mode: feed the input to a solver in fixed-size chunks
+// instead of loading it whole, so memory use does not grow with the
+// input size.
+
+struct stream_solution {
+    void *(*init)(void);
+    enum stream_status (*feed)(void *state, const char *chunk, size_t size);
+    // Produce the answer and free the state. Also called after an
+    // error, to free the state.
+    long long (*finish)(void *state);
+};
+
+// Peak resident set size of this process, in KB
+long stream_peak_rss_kb(void)
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) < 0)
+        return -1;
+
+    return usage.ru_maxrss;
+}
+
+// Stream the file at path ("-" for stdin) through s in chunks of
+// chunk_size bytes.
+int run_stream(const struct stream_solution *s, const char *path, size_t chunk_size)
+{
+    bool is_stdin = strcmp(path, "-") == 0;
+    int fd = is_stdin ? STDIN_FILENO : open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open file");
+        return 1;
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    char *chunk = malloc(chunk_size);
+    void *state = s->init();
+    if (!chunk || !state) {
+        perror("OOM");
+        free(chunk);
+        free(state);
+        if (!is_stdin) close(fd);
+        return 1;
+    }
+
+    uint64_t start = now_ns();
+    uint64_t total = 0;
+    enum stream_status status = STREAM_MORE;
+    while (status == STREAM_MORE) {
+        ssize_t n = read(fd, chunk, chunk_size);
+        if (n == 0) break;
+        if (n < 0) {
+            perror("Failed to read file");
+            status = STREAM_ERROR;
+            break;
+        }
+
+        total += (uint64_t)n;
+        status = s->feed(state, chunk, (size_t)n);
+    }
+
+    long long ans = s->finish(state);
+    uint64_t elapsed = now_ns() - start;
+
+    free(chunk);
+    if (!is_stdin) close(fd);
+
+    // Don't print an answer computed from part of the input
+    if (status == STREAM_ERROR) {
+        fprintf(stderr, "Streaming failed after %llu bytes\n", (unsigned long long)total);
+        return 1;
+    }
+
+    printf("Solution: %lld\n", ans);
+    fprintf(stderr, "Streamed %llu bytes in %.3f ms (%.1f MB/s), peak RSS %ld KB\n",
+            (unsigned long long)total, (double)elapsed / 1e6,
+            elapsed ? ((double)total / 1e6) / ((double)elapsed / 1e9) : 0.0,
+            stream_peak_rss_kb());
+    return 0;
+}
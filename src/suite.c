@@ -0,0 +1,176 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+// Benchmark suite: bench every solution against the inputs in a
+// directory and compare the medians with a stored baseline. Answers
+// are compared too, since a fast wrong answer is also a regression.
+
+struct suite_opts {
+    const char *dir;
+    const char *baseline;
+    double threshold;   // Allowed slowdown in percent
+    uint64_t budget_ns; // Rough time to spend measuring each solution
+    bool update;
+};
+
+struct suite_entry {
+    bool present;
+    struct bench_result res;
+};
+
+// Read a baseline file written by suite_write_baseline.
+// Return false if it does not exist.
+bool suite_read_baseline(const char *path, struct suite_entry baseline[][2], size_t days)
+{
+    FILE *file = fopen(path, "r");
+    if (!file) return false;
+
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        struct bench_result res = {0};
+        unsigned long long load_ns, min_ns, median_ns;
+        if (sscanf(line, "%d,%d,%zu,%llu,%zu,%lld,%llu,%llu",
+                   &res.day, &res.part, &res.input_size, &load_ns,
+                   &res.iters, &res.answer, &min_ns, &median_ns) != 8)
+            continue; // header
+
+        if (res.day < 1 || (size_t)res.day > days || res.part < 1 || res.part > 2)
+            continue;
+
+        res.min_ns = min_ns;
+        res.median_ns = median_ns;
+        baseline[res.day - 1][res.part - 1].present = true;
+        baseline[res.day - 1][res.part - 1].res = res;
+    }
+
+    fclose(file);
+    return true;
+}
+
+bool suite_write_baseline(const char *path, struct suite_entry results[][2], size_t days)
+{
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        perror("Failed to write baseline");
+        return false;
+    }
+
+    bench_print_csv_header(file);
+    for (size_t day = 0; day < days; day++)
+        for (size_t part = 0; part < 2; part++)
+            if (results[day][part].present)
+                bench_print(file, &results[day][part].res, BENCH_CSV);
+
+    fclose(file);
+    return true;
+}
+
+// Bench one solution, picking the iteration count from the budget.
+bool suite_bench(long long (*f)(const char *), const struct input_file *in,
+                 const struct suite_opts *opts, struct bench_result *res)
+{
+    int saved = bench_silence_stdout();
+    uint64_t start = now_ns();
+    f(in->data);
+    uint64_t once = now_ns() - start;
+    bench_restore_stdout(saved);
+
+    size_t iters = once > 0 ? (size_t)(opts->budget_ns / once) : 100;
+    if (iters < 5) iters = 5;
+    if (iters > 100) iters = 100;
+
+    struct bench_opts bopts = {
+        .iters = iters,
+        .warmup = 1,
+    };
+
+    res->input_size = in->size;
+    return bench_run(f, in->data, &bopts, res);
+}
+
+int run_suite(const struct suite_opts *opts)
+{
+    static struct suite_entry baseline[SIZE(solutions)][2];
+    static struct suite_entry results[SIZE(solutions)][2];
+    bool have_baseline = !opts->update
+        && suite_read_baseline(opts->baseline, baseline, SIZE(solutions));
+
+    printf("%-10s %14s %14s %9s  %s\n", "solution", "baseline (us)", "median (us)", "change", "status");
+
+    int regressions = 0;
+    for (size_t day = 1; day <= SIZE(solutions); day++) {
+        char fname[512];
+        snprintf(fname, sizeof(fname), "%s/day%02zu.txt", opts->dir, day);
+
+        struct input_file in;
+        bool loaded = false;
+        for (size_t part = 1; part <= 2; part++) {
+            long long (*f)(const char *) = solutions[day - 1][part - 1];
+            if (!f) continue;
+
+            if (!loaded) {
+                if (!load_input(&in, fname, LOAD_DEFAULT)) {
+                    fprintf(stderr, "Skipping day %zu: failed to read %s\n", day, fname);
+                    break;
+                }
+                loaded = true;
+            }
+
+            struct bench_result *res = &results[day - 1][part - 1].res;
+            res->day = (int)day;
+            res->part = (int)part;
+            if (!suite_bench(f, &in, opts, res)) continue;
+            results[day - 1][part - 1].present = true;
+
+            const struct suite_entry *base = &baseline[day - 1][part - 1];
+            if (!have_baseline || !base->present) {
+                printf("day%02zu/%zu   %14s %14.1f %9s  new\n",
+                       day, part, "-", (double)res->median_ns / 1e3, "-");
+                continue;
+            }
+
+            double change = 100.0 * ((double)res->median_ns - (double)base->res.median_ns)
+                / (double)base->res.median_ns;
+
+            const char *status = "ok";
+            if (base->res.input_size != res->input_size) {
+                // Timings against a different input mean nothing
+                status = "INPUT CHANGED";
+                regressions++;
+            } else if (base->res.answer != res->answer) {
+                status = "WRONG ANSWER";
+                regressions++;
+            } else if (change > opts->threshold) {
+                status = "REGRESSION";
+                regressions++;
+            } else if (change < -opts->threshold) {
+                status = "faster";
+            }
+
+            printf("day%02zu/%zu   %14.1f %14.1f %+8.1f%%  %s\n",
+                   day, part, (double)base->res.median_ns / 1e3,
+                   (double)res->median_ns / 1e3, change, status);
+        }
+
+        if (loaded)
+            unload_input(&in);
+    }
+
+    if (!have_baseline) {
+        if (!suite_write_baseline(opts->baseline, results, SIZE(solutions)))
+            return 1;
+        printf("\nWrote baseline to %s\n", opts->baseline);
+        return 0;
+    }
+
+    if (regressions > 0) {
+        printf("\n%d solution(s) regressed beyond %.1f%%\n", regressions, opts->threshold);
+        return 1;
+    }
+
+    printf("\nNo regressions beyond %.1f%%\n", opts->threshold);
+    return 0;
+}